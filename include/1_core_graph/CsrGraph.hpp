@@ -0,0 +1,138 @@
+#ifndef CSR_GRAPH_HPP
+#define CSR_GRAPH_HPP
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+
+/**
+ * @brief CSR の隣接頂点範囲 (ポインタの組)
+ */
+struct CsrRange {
+    const int* first;
+    const int* last;
+    const int* begin() const { return first; }
+    const int* end() const { return last; }
+    int size() const { return static_cast<int>(last - first); }
+};
+
+/**
+ * @brief 圧縮疎行 (CSR) 形式の無向グラフ
+ * 頂点 v の隣接頂点は adjacency[offsets[v] .. offsets[v+1]) に昇順で並びます。
+ * 構築後は読み取り専用で、頂点の絞り込みは別途「頂点マスク」で表現します。
+ */
+struct CsrGraph {
+    std::vector<int> offsets;   // 頂点数 + 1
+    std::vector<int> adjacency; // 有向辺数 (無向辺数 x 2)
+    std::vector<int> type_id;   // 頂点ID -> タイプID (タイプ不明は -1)
+
+    int vertexSize() const { return offsets.empty() ? 0 : static_cast<int>(offsets.size()) - 1; }
+    int degree(int v) const { return offsets[v + 1] - offsets[v]; }
+    CsrRange neighbors(int v) const {
+        return {adjacency.data() + offsets[v], adjacency.data() + offsets[v + 1]};
+    }
+};
+
+// 頂点マスク: 1 ならその頂点を含む (G' や G'' をグラフを作り直さずに表現する)
+using VertexMask = std::vector<uint8_t>;
+
+/**
+ * @brief 辺リストから CSR グラフを一括構築します (計数ソート、隣接頂点は昇順)。
+ * 自己ループと重複辺は取り除きます。
+ */
+inline CsrGraph buildCsrGraph(
+    int num_vertices,
+    const std::vector<std::pair<int, int>>& edges,
+    std::vector<int> type_id
+) {
+    CsrGraph g;
+    g.type_id = std::move(type_id);
+    g.type_id.resize(num_vertices, -1);
+
+    // 1. 次数を数える
+    std::vector<int> degree(num_vertices, 0);
+    for (const auto& e : edges) {
+        if (e.first == e.second) continue;
+        degree[e.first]++;
+        degree[e.second]++;
+    }
+    g.offsets.assign(num_vertices + 1, 0);
+    for (int v = 0; v < num_vertices; ++v) {
+        g.offsets[v + 1] = g.offsets[v] + degree[v];
+    }
+
+    // 2. 隣接頂点を詰める
+    std::vector<int> adjacency(g.offsets[num_vertices]);
+    std::vector<int> cursor(g.offsets.begin(), g.offsets.end() - 1);
+    for (const auto& e : edges) {
+        if (e.first == e.second) continue;
+        adjacency[cursor[e.first]++] = e.second;
+        adjacency[cursor[e.second]++] = e.first;
+    }
+
+    // 3. 頂点ごとに昇順ソートし、重複辺を除いて詰め直す
+    g.adjacency.reserve(adjacency.size());
+    std::vector<int> new_offsets(num_vertices + 1, 0);
+    for (int v = 0; v < num_vertices; ++v) {
+        auto first = adjacency.begin() + g.offsets[v];
+        auto last = adjacency.begin() + g.offsets[v + 1];
+        std::sort(first, last);
+        last = std::unique(first, last);
+        g.adjacency.insert(g.adjacency.end(), first, last);
+        new_offsets[v + 1] = static_cast<int>(g.adjacency.size());
+    }
+    g.offsets.swap(new_offsets);
+    return g;
+}
+
+/**
+ * @brief マスク付きグラフ上の BFS (配列ベースのフロンティア掃引) でホップ数を求めます。
+ * distances[v] = source からのホップ数 (到達不能またはマスク外は -1)
+ * 作業用配列は呼び出し側から渡すことができ、その場合は追加のメモリ確保を行いません。
+ */
+inline void bfsDistances(
+    const CsrGraph& g,
+    const VertexMask& mask,
+    int source,
+    std::vector<int>& distances,
+    std::vector<int>& frontier,
+    std::vector<int>& next_frontier
+) {
+    int n = g.vertexSize();
+    distances.assign(n, -1);
+    frontier.clear();
+    next_frontier.clear();
+    if (source < 0 || source >= n || !mask[source]) return;
+
+    distances[source] = 0;
+    frontier.push_back(source);
+    int depth = 0;
+    while (!frontier.empty()) {
+        ++depth;
+        for (int u : frontier) {
+            for (int v : g.neighbors(u)) {
+                if (mask[v] && distances[v] < 0) {
+                    distances[v] = depth;
+                    next_frontier.push_back(v);
+                }
+            }
+        }
+        frontier.swap(next_frontier);
+        next_frontier.clear();
+    }
+}
+
+/**
+ * @brief マスク付きグラフ上で、マスク内に隣接頂点を1つ以上持つかを判定します。
+ * (従来の隣接リスト表現では、辺を持たない頂点はグラフに現れなかったため)
+ */
+inline bool hasMaskedNeighbor(const CsrGraph& g, const VertexMask& mask, int v) {
+    if (!mask[v]) return false;
+    for (int u : g.neighbors(v)) {
+        if (mask[u]) return true;
+    }
+    return false;
+}
+
+#endif // CSR_GRAPH_HPP
@@ -0,0 +1,428 @@
+#ifndef DEFINITION_CACHE_HPP
+#define DEFINITION_CACHE_HPP
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include "1_core_graph/GraphLoader.hpp"
+#include "1_core_graph/MappedFile.hpp"
+#include "1_core_graph/MakeBaseGraph.hpp"
+#include "1_core_graph/GridHashMap.hpp" // mixHash64
+#include "1_core_graph/Logging.hpp"
+#include "3_geometry/ObjTypes.hpp"
+
+// --- コンパイル済み定義ファイル (バイナリキャッシュ) ---
+// 書式 (すべてネイティブのバイト順, 各項目は 8 バイト境界に揃える):
+//   ヘッダ: マジック "GRDEFCAC", 版数, 元ファイルのバイト数, 元ファイルの内容ハッシュ, 格子の段数 n (無ければ -1),
+//           格子を作った make_base_graph の版数 (kBaseGraphGeneratorVersion)
+//   本体:   コアグラフの辺 (頂点名の組, 読んだ順), 規則, タイプごとのメッシュ (座標列と CSR の面),
+//           [n >= 0 のとき] 格子 (タイプ名, コア座標, コア間接続, full_graph)
+// 配列はマップしたファイルをそのまま指すビューとして読み出し、コピーは最後に必要な型へ変換するときだけ行います。
+
+constexpr char kDefinitionCacheMagic[8] = {'G', 'R', 'D', 'E', 'F', 'C', 'A', 'C'};
+constexpr uint64_t kDefinitionCacheVersion = 2;
+
+/**
+ * @brief 元ファイルの内容ハッシュ (8 バイトずつ mixHash64 で畳み込む)
+ */
+inline uint64_t hashSourceBytes(const char* data, size_t size) {
+    uint64_t h = mixHash64(static_cast<uint64_t>(size) ^ 0x9e3779b97f4a7c15ULL);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        h = mixHash64(h ^ word);
+    }
+    uint64_t tail = 0;
+    if (i < size) std::memcpy(&tail, data + i, size - i);
+    return mixHash64(h ^ tail);
+}
+
+/**
+ * @brief 既定の格子の段数 (タイプ数 - 1, 最低 1)
+ */
+inline int defaultLatticeDepth(const CoreGraph& core_graph) {
+    return std::max(1, core_graph.vertexSize() - 1);
+}
+
+/**
+ * @brief マップしたメモリ上の配列を指す読み取り専用ビュー
+ */
+template <typename T>
+struct ArrayView {
+    const T* first = nullptr;
+    size_t count = 0;
+    const T* begin() const { return first; }
+    const T* end() const { return first + count; }
+    size_t size() const { return count; }
+    const T& operator[](size_t i) const { return first[i]; }
+};
+
+/**
+ * @brief キャッシュの書き出し用バッファ
+ */
+class DefinitionCacheWriter {
+public:
+    void putU64(uint64_t value) { putBytes(&value, sizeof(value)); }
+    void putString(std::string_view s) {
+        putU64(s.size());
+        putBytes(s.data(), s.size());
+    }
+    template <typename T>
+    void putArray(const T* data, size_t count) {
+        static_assert(std::is_trivially_copyable<T>::value, "cache arrays must be trivially copyable");
+        putU64(count);
+        putBytes(data, count * sizeof(T));
+    }
+    void putBytes(const void* data, size_t size) {
+        buffer_.append(static_cast<const char*>(data), size);
+        buffer_.append((8 - buffer_.size() % 8) % 8, '\0'); // 8 バイト境界に揃える
+    }
+    const std::string& bytes() const { return buffer_; }
+
+private:
+    std::string buffer_;
+};
+
+/**
+ * @brief キャッシュの読み出し用カーソル (範囲外を読もうとしたら例外)
+ */
+class DefinitionCacheReader {
+public:
+    DefinitionCacheReader(const char* data, size_t size, const std::string& source_name)
+        : data_(data), size_(size), source_name_(source_name) {}
+
+    const char* getBytes(size_t size) {
+        size_t padded = size + (8 - size % 8) % 8;
+        if (padded < size || padded > size_ - pos_) {
+            throw std::runtime_error("Error: Corrupt definition cache (truncated): " + source_name_);
+        }
+        const char* bytes = data_ + pos_;
+        pos_ += padded;
+        return bytes;
+    }
+    uint64_t getU64() {
+        uint64_t value;
+        std::memcpy(&value, getBytes(sizeof(value)), sizeof(value));
+        return value;
+    }
+    std::string_view getString() {
+        size_t length = checkedCount(1);
+        return std::string_view(getBytes(length), length);
+    }
+    template <typename T>
+    ArrayView<T> getArray() {
+        static_assert(alignof(T) <= 8, "cache arrays are aligned to 8 bytes");
+        ArrayView<T> view;
+        view.count = checkedCount(sizeof(T));
+        view.first = reinterpret_cast<const T*>(getBytes(view.count * sizeof(T)));
+        return view;
+    }
+    size_t remaining() const { return size_ - pos_; }
+
+private:
+    // 要素数を読み、残りのバイト数に収まるか確かめる
+    size_t checkedCount(size_t element_size) {
+        uint64_t count = getU64();
+        if (count > remaining() / element_size) {
+            throw std::runtime_error("Error: Corrupt definition cache (bad length): " + source_name_);
+        }
+        return static_cast<size_t>(count);
+    }
+
+    const char* data_;
+    size_t size_;
+    size_t pos_ = 0;
+    std::string source_name_;
+};
+
+// コンパイル済みの規則 (頂点名はマップしたファイルを指す)
+struct CompiledRuleView {
+    Point3D vector;
+    std::vector<std::pair<std::string_view, std::string_view>> connections;
+};
+
+// コンパイル済みのメッシュ (面は CSR: 面 f の頂点は face_indices[face_offsets[f] .. face_offsets[f+1]))
+struct CompiledMeshView {
+    std::string_view type_name;
+    ArrayView<Point3D> vertices;
+    ArrayView<int> face_offsets;
+    ArrayView<int> face_indices;
+    int faceSize() const { return static_cast<int>(face_offsets.size()) - 1; }
+    FaceRange face(int f) const {
+        return {face_indices.begin() + face_offsets[f], face_indices.begin() + face_offsets[f + 1]};
+    }
+};
+
+/**
+ * @brief compileDefinitionCache のオプション
+ */
+struct DefinitionCacheOptions {
+    bool include_base_graph = true; // 格子 (GraphData) も書き出す
+    int n = -1;                     // 格子の段数 (-1 なら defaultLatticeDepth)
+};
+
+/**
+ * @brief 定義ファイルを読み込み、コンパイル済みのバイナリキャッシュとして書き出します。
+ * 書き込みは一時ファイルに行ってから置き換えるため、途中で失敗しても壊れたキャッシュは残りません。
+ */
+inline void compileDefinitionCache(
+    const std::string& definition_file,
+    const std::string& cache_file,
+    std::ostream& log_stream,
+    const DefinitionCacheOptions& options = DefinitionCacheOptions()
+) {
+    static_assert(sizeof(int) == 4, "the cache stores indices as 32-bit ints");
+
+    CoreGraph core_graph;
+    std::vector<ConnectionRule> rules;
+    std::map<std::string, ObjMesh> mesh_data;
+    std::vector<std::pair<std::string, std::string>> core_edges;
+
+    std::unique_ptr<MappedFile> source;
+    try {
+        source.reset(new MappedFile(definition_file));
+    } catch (const std::exception&) {
+        throw std::runtime_error("Error: Cannot open definition file: " + definition_file);
+    }
+    parseDefinitions(source->data(), source->size(), definition_file, core_graph, rules, mesh_data, &core_edges);
+
+    int n = -1;
+    GraphData base_data;
+    if (options.include_base_graph) {
+        n = options.n >= 0 ? options.n : defaultLatticeDepth(core_graph);
+        base_data = make_base_graph(core_graph, rules, n, log_stream, BaseGraphOptions{false});
+    }
+
+    DefinitionCacheWriter writer;
+    writer.putBytes(kDefinitionCacheMagic, sizeof(kDefinitionCacheMagic));
+    writer.putU64(kDefinitionCacheVersion);
+    writer.putU64(source->size());
+    writer.putU64(hashSourceBytes(source->data(), source->size()));
+    writer.putU64(static_cast<uint64_t>(static_cast<int64_t>(n)));
+    writer.putU64(kBaseGraphGeneratorVersion);
+
+    writer.putU64(core_edges.size());
+    for (const auto& edge : core_edges) {
+        writer.putString(edge.first);
+        writer.putString(edge.second);
+    }
+    writer.putU64(rules.size());
+    for (const ConnectionRule& rule : rules) {
+        writer.putArray(&rule.vector, 1);
+        writer.putU64(rule.connections.size());
+        for (const auto& conn : rule.connections) {
+            writer.putString(conn.first);
+            writer.putString(conn.second);
+        }
+    }
+    writer.putU64(mesh_data.size());
+    for (const auto& type_mesh : mesh_data) {
+        PackedMesh packed = packMesh(type_mesh.second);
+        writer.putString(type_mesh.first);
+        writer.putArray(type_mesh.second.vertices.data(), type_mesh.second.vertices.size());
+        writer.putArray(packed.face_offsets.data(), packed.face_offsets.size());
+        writer.putArray(packed.face_indices.data(), packed.face_indices.size());
+    }
+    if (n >= 0) {
+        writer.putU64(base_data.vertex_types.size());
+        for (const std::string& type_name : base_data.vertex_types) writer.putString(type_name);
+        writer.putArray(base_data.core_locations.data(), base_data.core_locations.size());
+        std::vector<int> flat;
+        for (const auto& pair : base_data.core_connectivity) flat.insert(flat.end(), {pair.first, pair.second});
+        writer.putArray(flat.data(), flat.size());
+        writer.putU64(base_data.full_graph.id_bound);
+        writer.putU64(base_data.full_graph.num_vertices);
+        flat.clear();
+        for (const auto& edge : base_data.full_graph.edges) flat.insert(flat.end(), {edge.first, edge.second});
+        writer.putArray(flat.data(), flat.size());
+    }
+
+    std::string temp_file = cache_file + ".tmp";
+    {
+        std::ofstream out(temp_file, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            throw std::runtime_error("Error: Cannot open cache file for writing: " + temp_file);
+        }
+        out.write(writer.bytes().data(), static_cast<std::streamsize>(writer.bytes().size()));
+        if (!out) {
+            throw std::runtime_error("Error: Failed to write cache file: " + temp_file);
+        }
+    }
+    if (std::rename(temp_file.c_str(), cache_file.c_str()) != 0) {
+        std::remove(temp_file.c_str());
+        throw std::runtime_error("Error: Cannot replace cache file: " + cache_file);
+    }
+    if (GR_LOG_ENABLED(LogLevel::Info, LogSubsystem::Lattice)) {
+        log_stream << "Compiled " << definition_file << " -> " << cache_file << " (" << writer.bytes().size() << " bytes";
+        if (n >= 0) log_stream << ", base graph n=" << n << ": " << base_data.core_locations.size() << " cores";
+        log_stream << ")." << '\n';
+    }
+    log_stream.flush();
+}
+
+/**
+ * @brief マップしたコンパイル済みキャッシュ
+ * 構築時に構造だけを検査し、配列はファイルを指すビューとして持ちます (ビューはこのオブジェクトが生きている間だけ有効)。
+ * 版数が違うキャッシュや壊れたキャッシュは例外で報告します。元ファイルと一致するかは matchesSource で確かめてください。
+ */
+class CompiledDefinitions {
+public:
+    explicit CompiledDefinitions(const std::string& cache_file) : file_(cache_file) {
+        DefinitionCacheReader reader(file_.data(), file_.size(), cache_file);
+        if (file_.size() < sizeof(kDefinitionCacheMagic) ||
+            std::memcmp(reader.getBytes(sizeof(kDefinitionCacheMagic)), kDefinitionCacheMagic, sizeof(kDefinitionCacheMagic)) != 0) {
+            throw std::runtime_error("Error: Not a definition cache: " + cache_file);
+        }
+        uint64_t version = reader.getU64();
+        if (version != kDefinitionCacheVersion) {
+            throw std::runtime_error("Error: Definition cache " + cache_file + " has format version " + std::to_string(version) +
+                                     " (expected " + std::to_string(kDefinitionCacheVersion) + ")");
+        }
+        source_size_ = reader.getU64();
+        source_hash_ = reader.getU64();
+        base_graph_n_ = static_cast<int>(static_cast<int64_t>(reader.getU64()));
+        base_graph_generator_ = reader.getU64();
+
+        for (uint64_t i = 0, count = reader.getU64(); i < count; ++i) {
+            std::string_view v1 = reader.getString();
+            std::string_view v2 = reader.getString();
+            core_edges_.push_back({v1, v2});
+        }
+        for (uint64_t i = 0, count = reader.getU64(); i < count; ++i) {
+            CompiledRuleView rule;
+            ArrayView<Point3D> vector = reader.getArray<Point3D>();
+            if (vector.size() != 1) throw std::runtime_error("Error: Corrupt definition cache (rule vector): " + cache_file);
+            rule.vector = vector[0];
+            for (uint64_t c = 0, num_connections = reader.getU64(); c < num_connections; ++c) {
+                std::string_view v1 = reader.getString();
+                std::string_view v2 = reader.getString();
+                rule.connections.push_back({v1, v2});
+            }
+            rules_.push_back(std::move(rule));
+        }
+        for (uint64_t i = 0, count = reader.getU64(); i < count; ++i) {
+            CompiledMeshView mesh;
+            mesh.type_name = reader.getString();
+            mesh.vertices = reader.getArray<Point3D>();
+            mesh.face_offsets = reader.getArray<int>();
+            mesh.face_indices = reader.getArray<int>();
+            if (mesh.face_offsets.size() == 0 || mesh.face_offsets[0] != 0 ||
+                mesh.face_offsets[mesh.face_offsets.size() - 1] != static_cast<int>(mesh.face_indices.size())) {
+                throw std::runtime_error("Error: Corrupt definition cache (mesh faces): " + cache_file);
+            }
+            meshes_.push_back(mesh);
+        }
+        if (base_graph_n_ >= 0) {
+            for (uint64_t i = 0, count = reader.getU64(); i < count; ++i) vertex_types_.push_back(reader.getString());
+            core_locations_ = reader.getArray<Point3D>();
+            core_connectivity_ = reader.getArray<int>();
+            full_graph_id_bound_ = static_cast<int>(reader.getU64());
+            full_graph_vertices_ = static_cast<int>(reader.getU64());
+            full_graph_edges_ = reader.getArray<int>();
+        }
+    }
+
+    uint64_t sourceSize() const { return source_size_; }
+    uint64_t sourceHash() const { return source_hash_; }
+
+    /**
+     * @brief 元ファイルの内容 (バイト数と内容ハッシュ) がキャッシュを作ったときと一致するか
+     */
+    bool matchesSource(const char* data, size_t size) const {
+        return size == source_size_ && hashSourceBytes(data, size) == source_hash_;
+    }
+
+    // 格子は、今の make_base_graph と同じ版数で作られたものだけを使う (古い格子は hasStaleBaseGraph で分かる)
+    bool hasBaseGraph() const { return base_graph_n_ >= 0 && base_graph_generator_ == kBaseGraphGeneratorVersion; }
+    bool hasStaleBaseGraph() const { return base_graph_n_ >= 0 && base_graph_generator_ != kBaseGraphGeneratorVersion; }
+    int baseGraphDepth() const { return base_graph_n_; }
+
+    // --- ビュー ---
+    const std::vector<std::pair<std::string_view, std::string_view>>& coreEdges() const { return core_edges_; }
+    const std::vector<CompiledRuleView>& rules() const { return rules_; }
+    const std::vector<CompiledMeshView>& meshes() const { return meshes_; }
+
+    /**
+     * @brief ビューから loadDefinitions と同じ形のデータを組み立てます。
+     */
+    void materializeDefinitions(
+        CoreGraph& core_graph,
+        std::vector<ConnectionRule>& rules,
+        std::map<std::string, ObjMesh>& mesh_data
+    ) const {
+        core_graph = CoreGraph();
+        rules.clear();
+        mesh_data.clear();
+        for (const auto& edge : core_edges_) {
+            core_graph.addEdge(std::string(edge.first), std::string(edge.second));
+        }
+        core_graph.update();
+        for (const CompiledRuleView& view : rules_) {
+            ConnectionRule rule;
+            rule.vector = view.vector;
+            for (const auto& conn : view.connections) {
+                rule.connections.push_back({std::string(conn.first), std::string(conn.second)});
+            }
+            rules.push_back(std::move(rule));
+        }
+        for (const CompiledMeshView& view : meshes_) {
+            ObjMesh& mesh = mesh_data[std::string(view.type_name)];
+            mesh.vertices.assign(view.vertices.begin(), view.vertices.end());
+            mesh.faces.reserve(view.faceSize());
+            for (int f = 0; f < view.faceSize(); ++f) {
+                FaceRange face = view.face(f);
+                mesh.faces.emplace_back(face.begin(), face.end());
+            }
+        }
+    }
+
+    /**
+     * @brief キャッシュした格子から GraphData を組み立てます (hasBaseGraph() が true のときだけ)。
+     */
+    GraphData materializeBaseGraph() const {
+        if (!hasBaseGraph()) throw std::logic_error("materializeBaseGraph: the cache has no base graph");
+        GraphData data;
+        for (std::string_view type_name : vertex_types_) data.vertex_types.emplace_back(type_name);
+        data.core_locations.assign(core_locations_.begin(), core_locations_.end());
+        data.core_connectivity.reserve(core_connectivity_.size() / 2);
+        for (size_t i = 0; i + 1 < core_connectivity_.size(); i += 2) {
+            data.core_connectivity.push_back({core_connectivity_[i], core_connectivity_[i + 1]});
+        }
+        data.full_graph.id_bound = full_graph_id_bound_;
+        data.full_graph.num_vertices = full_graph_vertices_;
+        data.full_graph.edges.reserve(full_graph_edges_.size() / 2);
+        for (size_t i = 0; i + 1 < full_graph_edges_.size(); i += 2) {
+            data.full_graph.edges.push_back({full_graph_edges_[i], full_graph_edges_[i + 1]});
+        }
+        return data;
+    }
+
+private:
+    MappedFile file_;
+    uint64_t source_size_ = 0;
+    uint64_t source_hash_ = 0;
+    int base_graph_n_ = -1;
+    uint64_t base_graph_generator_ = 0;
+    std::vector<std::pair<std::string_view, std::string_view>> core_edges_;
+    std::vector<CompiledRuleView> rules_;
+    std::vector<CompiledMeshView> meshes_;
+    std::vector<std::string_view> vertex_types_;
+    ArrayView<Point3D> core_locations_;
+    ArrayView<int> core_connectivity_; // (id1, id2) を平坦に並べたもの
+    int full_graph_id_bound_ = 0;
+    int full_graph_vertices_ = 0;
+    ArrayView<int> full_graph_edges_;  // (u, v) を平坦に並べたもの
+};
+
+#endif // DEFINITION_CACHE_HPP
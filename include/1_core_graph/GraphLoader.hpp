@@ -2,13 +2,16 @@
 #define GRAPH_LOADER_HPP
 
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <memory>
+#include <cstring>
+#include <charconv>
 #include <stdexcept>
-#include "1_core_graph/MakeBaseGraph.hpp" 
+#include "1_core_graph/MakeBaseGraph.hpp"
+#include "1_core_graph/MappedFile.hpp"
 #include "3_geometry/ObjTypes.hpp" // ObjMesh 構造体のため
 
 // 読み込み状態を管理するための列挙型
@@ -16,103 +19,167 @@ enum class ParseState {
     None,
     ReadingCore,
     ReadingRules,
-    ReadingMesh 
+    ReadingMesh
 };
 
 /**
- * @brief 1つの定義ファイルからコアグラフ、ルール、メッシュを読み込みます。
+ * @brief 1行分の文字列を空白区切りのトークンに分けるカーソル (コピーもメモリ確保もしない)
  */
-inline void loadDefinitions(
-    const std::string& filename, 
-    CoreGraph& core_graph, 
-    std::vector<ConnectionRule>& rules,
-    std::map<std::string, ObjMesh>& mesh_data
-) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        throw std::runtime_error("Error: Cannot open definition file: " + filename);
+struct DefinitionLine {
+    const char* cur;
+    const char* end;
+
+    static bool isSpace(char ch) {
+        return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\v' || ch == '\f';
+    }
+
+    // 次のトークンを取り出します (無ければ false)
+    bool nextToken(std::string_view& token) {
+        while (cur < end && isSpace(*cur)) ++cur;
+        if (cur == end) return false;
+        const char* start = cur;
+        while (cur < end && !isSpace(*cur)) ++cur;
+        token = std::string_view(start, cur - start);
+        return true;
     }
+};
 
+// ヘルパー: トークン全体を実数として読む (先頭の '+' も許す)
+inline bool parseDefinitionDouble(std::string_view token, double& value) {
+    if (!token.empty() && token[0] == '+') token.remove_prefix(1);
+    const char* last = token.data() + token.size();
+    auto result = std::from_chars(token.data(), last, value);
+    return result.ec == std::errc() && result.ptr == last;
+}
+
+// ヘルパー: トークン先頭の整数を読む (complete はトークン全体が整数だったか)
+inline bool parseDefinitionInt(std::string_view token, int& value, bool& complete) {
+    if (!token.empty() && token[0] == '+') token.remove_prefix(1);
+    const char* last = token.data() + token.size();
+    auto result = std::from_chars(token.data(), last, value);
+    complete = (result.ptr == last);
+    return result.ec == std::errc();
+}
+
+/**
+ * @brief メモリ上の定義ファイルの内容からコアグラフ、ルール、メッシュを読み込みます。
+ * 書式は CORE_GRAPH / RULES / VERTEX_MESH の各セクションと、'#' で始まるコメント行です。
+ * 数値の誤りなどは「ファイル名:行番号」付きの例外で報告します。
+ * core_edges があれば、コアグラフに追加した辺 (頂点名の組) を読んだ順に記録します。
+ */
+inline void parseDefinitions(
+    const char* data,
+    size_t size,
+    const std::string& source_name,
+    CoreGraph& core_graph,
+    std::vector<ConnectionRule>& rules,
+    std::map<std::string, ObjMesh>& mesh_data,
+    std::vector<std::pair<std::string, std::string>>* core_edges = nullptr
+) {
     // 古いデータをクリア
     core_graph = CoreGraph();
     rules.clear();
     mesh_data.clear();
+    if (core_edges) core_edges->clear();
 
-    std::string line, keyword;
     ParseState state = ParseState::None;
     ConnectionRule current_rule;
     bool in_rule = false;
-    
-    std::string current_mesh_type = ""; 
+    ObjMesh* current_mesh = nullptr; // 読み込み中のメッシュ (タイプ名の無い VERTEX_MESH では nullptr)
 
-    while (std::getline(file, line)) {
-        if (line.empty() || line[0] == '#') continue; 
-        
-        std::stringstream ss(line);
-        ss >> keyword;
+    const char* p = data;
+    const char* data_end = data + size;
+    int line_number = 0;
+    std::vector<int> face_indices;
+
+    auto fail = [&](const std::string& message) {
+        throw std::runtime_error("Error: " + source_name + ":" + std::to_string(line_number) + ": " + message);
+    };
+    auto readDouble = [&](DefinitionLine& line, double& value, const char* what) {
+        std::string_view token;
+        if (!line.nextToken(token)) fail(std::string("missing ") + what);
+        if (!parseDefinitionDouble(token, value)) fail(std::string("invalid number for ") + what + ": '" + std::string(token) + "'");
+    };
+
+    while (p < data_end) {
+        const char* newline = static_cast<const char*>(std::memchr(p, '\n', data_end - p));
+        const char* line_end = newline ? newline : data_end;
+        DefinitionLine line{p, line_end};
+        p = newline ? newline + 1 : data_end;
+        line_number++;
+
+        if (line.cur == line.end || *line.cur == '#') continue;
+
+        std::string_view keyword;
+        if (!line.nextToken(keyword)) continue; // 空白だけの行
 
         if (keyword == "CORE_GRAPH") {
             state = ParseState::ReadingCore;
-            current_mesh_type = ""; 
+            current_mesh = nullptr;
             continue;
         } else if (keyword == "RULES") {
             state = ParseState::ReadingRules;
-            current_mesh_type = ""; 
+            current_mesh = nullptr;
             continue;
-        } else if (keyword == "VERTEX_MESH") { 
+        } else if (keyword == "VERTEX_MESH") {
             state = ParseState::ReadingMesh;
-            ss >> current_mesh_type; 
-            if (!current_mesh_type.empty()) {
-                mesh_data[current_mesh_type] = ObjMesh(); 
+            std::string_view type_name;
+            current_mesh = nullptr;
+            if (line.nextToken(type_name)) {
+                current_mesh = &mesh_data[std::string(type_name)];
+                *current_mesh = ObjMesh();
             }
             continue;
         }
 
         switch (state) {
-            // --- ▼ 修正点: vertexId() 呼び出しを削除 ▼ ---
             case ParseState::ReadingCore: {
-                std::string v1 = keyword; 
-                std::string v2;
-                ss >> v2;
-
-                if (!v2.empty()) {
+                std::string_view v2;
+                if (line.nextToken(v2)) {
                     // addEdgeだけで、tdzdd::Graphは頂点を認識します
-                    core_graph.addEdge(v1, v2);
+                    core_graph.addEdge(std::string(keyword), std::string(v2));
+                    if (core_edges) core_edges->push_back({std::string(keyword), std::string(v2)});
                 }
                 break;
             }
-            // --- ▲ 修正点 ▲ ---
             case ParseState::ReadingRules: {
                 if (keyword == "RULE") {
                     if (in_rule) rules.push_back(current_rule);
                     current_rule = ConnectionRule();
                     in_rule = true;
                 } else if (keyword == "VECTOR") {
-                    ss >> current_rule.vector.x >> current_rule.vector.y >> current_rule.vector.z;
+                    readDouble(line, current_rule.vector.x, "VECTOR x");
+                    readDouble(line, current_rule.vector.y, "VECTOR y");
+                    readDouble(line, current_rule.vector.z, "VECTOR z");
                 } else if (keyword == "CONNECT") {
-                    std::string v1, v2;
-                    ss >> v1 >> v2;
-                    current_rule.connections.push_back({v1, v2});
+                    std::string_view v1, v2;
+                    if (!line.nextToken(v1) || !line.nextToken(v2)) fail("CONNECT needs two vertex types");
+                    current_rule.connections.push_back({std::string(v1), std::string(v2)});
                 }
                 break;
             }
             case ParseState::ReadingMesh: {
-                if (current_mesh_type.empty()) break; 
-
-                ObjMesh& current_mesh = mesh_data.at(current_mesh_type);
+                if (!current_mesh) break;
 
                 if (keyword == "v") {
-                    Point3D p;
-                    ss >> p.x >> p.y >> p.z;
-                    current_mesh.vertices.push_back(p);
+                    Point3D point;
+                    readDouble(line, point.x, "vertex x");
+                    readDouble(line, point.y, "vertex y");
+                    readDouble(line, point.z, "vertex z");
+                    current_mesh->vertices.push_back(point);
                 } else if (keyword == "f") {
-                    std::vector<int> face_indices;
-                    int idx;
-                    while (ss >> idx) {
+                    // 頂点番号を読めるだけ読む ("1/2/3" のような書式は先頭の番号で打ち切る)
+                    face_indices.clear();
+                    std::string_view token;
+                    while (line.nextToken(token)) {
+                        int idx;
+                        bool complete;
+                        if (!parseDefinitionInt(token, idx, complete)) break;
                         face_indices.push_back(idx - 1); // 0-based
+                        if (!complete) break;
                     }
                     if (face_indices.size() >= 3) {
-                        current_mesh.faces.push_back(face_indices);
+                        current_mesh->faces.push_back(face_indices);
                     }
                 }
                 break;
@@ -121,11 +188,31 @@ inline void loadDefinitions(
                 break;
         }
     }
-    
+
     if (in_rule) {
         rules.push_back(current_rule); // 最後のルールを追加
     }
 
     core_graph.update();
 }
-#endif // GRAPH_LOADER_HPP
\ No newline at end of file
+
+/**
+ * @brief 1つの定義ファイルからコアグラフ、ルール、メッシュを読み込みます。
+ * ファイルはメモリにマップして、行ごとのコピーをせずに読み進めます。
+ */
+inline void loadDefinitions(
+    const std::string& filename,
+    CoreGraph& core_graph,
+    std::vector<ConnectionRule>& rules,
+    std::map<std::string, ObjMesh>& mesh_data,
+    std::vector<std::pair<std::string, std::string>>* core_edges = nullptr
+) {
+    std::unique_ptr<MappedFile> file;
+    try {
+        file.reset(new MappedFile(filename));
+    } catch (const std::exception&) {
+        throw std::runtime_error("Error: Cannot open definition file: " + filename);
+    }
+    parseDefinitions(file->data(), file->size(), filename, core_graph, rules, mesh_data, core_edges);
+}
+#endif // GRAPH_LOADER_HPP
@@ -0,0 +1,100 @@
+#ifndef GRID_HASH_MAP_HPP
+#define GRID_HASH_MAP_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+/**
+ * @brief 64bit 整数の攪拌 (splitmix64 の最終段)
+ */
+inline uint64_t mixHash64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * @brief 開番地法 (線形探査) のハッシュマップ
+ * キーと値を平坦な配列に並べて持つため、std::map と違ってノードごとのメモリ確保やポインタ追跡がありません。
+ * 要素の削除はできません (格子生成のように挿入と検索だけを行う用途向け)。
+ * Hasher は Key -> uint64_t の関数オブジェクト、Key は operator== を持つ必要があります。
+ */
+template <typename Key, typename Value, typename Hasher>
+class OpenAddressingMap {
+public:
+    explicit OpenAddressingMap(size_t expected_size = 16) {
+        size_t capacity = 16;
+        while (capacity < expected_size * 2) capacity <<= 1;
+        slots_.resize(capacity);
+    }
+
+    size_t size() const { return size_; }
+
+    /**
+     * @brief キーを検索します。見つからなければ nullptr を返します。
+     */
+    const Value* find(const Key& key) const {
+        size_t mask = slots_.size() - 1;
+        for (size_t i = Hasher()(key) & mask;; i = (i + 1) & mask) {
+            const Slot& slot = slots_[i];
+            if (!slot.used) return nullptr;
+            if (slot.key == key) return &slot.value;
+        }
+    }
+
+    /**
+     * @brief キーが無ければ value で挿入します。
+     * 戻り値は (格納されている値への参照, 新規に挿入したか)
+     * (参照は次の挿入で再配置されるまで有効です)
+     */
+    std::pair<Value&, bool> tryEmplace(const Key& key, const Value& value) {
+        if ((size_ + 1) * 2 > slots_.size()) grow();
+        size_t mask = slots_.size() - 1;
+        for (size_t i = Hasher()(key) & mask;; i = (i + 1) & mask) {
+            Slot& slot = slots_[i];
+            if (!slot.used) {
+                slot.used = true;
+                slot.key = key;
+                slot.value = value;
+                size_++;
+                return {slot.value, true};
+            }
+            if (slot.key == key) return {slot.value, false};
+        }
+    }
+
+private:
+    struct Slot {
+        Key key{};
+        Value value{};
+        bool used = false;
+    };
+
+    // 負荷率を 1/2 以下に保つよう容量を2倍にして再挿入
+    void grow() {
+        std::vector<Slot> old_slots(slots_.size() * 2);
+        old_slots.swap(slots_);
+        size_t mask = slots_.size() - 1;
+        for (const Slot& old_slot : old_slots) {
+            if (!old_slot.used) continue;
+            size_t i = Hasher()(old_slot.key) & mask;
+            while (slots_[i].used) i = (i + 1) & mask;
+            slots_[i] = old_slot;
+        }
+    }
+
+    std::vector<Slot> slots_;
+    size_t size_ = 0;
+};
+
+// 64bit 整数キー用のハッシュ
+struct UInt64Hasher {
+    uint64_t operator()(uint64_t key) const { return mixHash64(key); }
+};
+
+#endif // GRID_HASH_MAP_HPP
@@ -0,0 +1,293 @@
+#ifndef INSTRUMENTATION_HPP
+#define INSTRUMENTATION_HPP
+
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <utility>
+#include <ostream>
+#include <iomanip>
+#include <cstdio>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include "1_core_graph/Logging.hpp" // (要約にコンパイル時のログの上限を記録するため)
+
+// --- 段階ごとの計時とカウンタ ---
+// 段階の時間は ScopedPhase で計り、カウンタは addCounter / maxCounter で数えます (プロセス全体で1組)。
+// 段階の時間はスレッドごとの「排他的な」時間の合計です: 計時中に同じスレッドで別の段階が始まると、
+// 外側の段階は内側が終わるまで止まります (例: 探索の解シンクの中でのメッシュ構築は backtracking に含めない)。
+// 複数のスレッドで並行して進む段階 (--threads の backtracking, --pipeline-threads の後処理) は、各スレッドの時間の合計になります。
+// GRADUATION_RESEARCH_INSTRUMENTATION を 0 にすると、計時とカウンタはコンパイル時に消えます。
+//
+// 増分モード (--incremental) では、解ごとのメッシュ構築を行わないため、一部の項目の意味が変わります:
+//   mesh_build       代表解のメッシュの作り直し (finish) だけ。探索パスに沿った部品の積み下ろしは backtracking に含まれる
+//   dual_build       解ごとの増分状態からの双対グラフの書き出しと、代表解の双対グラフの作り直し
+//   coincident_faces_removed  解ごとに増分状態から数える (通常モードと同じ値。代表解の作り直しの分は数えない)
+
+#ifndef GRADUATION_RESEARCH_INSTRUMENTATION
+#define GRADUATION_RESEARCH_INSTRUMENTATION 1
+#endif
+
+// ビルドの識別子 (コードの版): 実行の要約に記録し、コードの版をまたいだ比較に使います。
+// ビルド時に文字列で与えてください (例: -DGRADUATION_RESEARCH_BUILD_ID="\"$(git describe --always --dirty)\"")。
+#ifndef GRADUATION_RESEARCH_BUILD_ID
+#define GRADUATION_RESEARCH_BUILD_ID "unknown"
+#endif
+
+enum class Phase : int {
+    Load = 0,     // 定義ファイル (またはキャッシュ) の読み込み
+    BaseGraph,    // make_base_graph
+    BfsPruning,   // G'/G'' の構築 (BFS による枝刈り) と探索グラフ・対称性の準備
+    Backtracking, // バックトラッキング探索
+    MeshBuild,    // 解のメッシュ構築
+    DualBuild,    // 双対グラフ構築
+    Nauty,        // nauty による正規化・自己同型群の計算
+    Export,       // 結果ファイルの書式化と書き出し (メインスレッド側)
+    Count
+};
+
+enum class Counter : int {
+    SearchNodes = 0,        // 訪問した探索ノード数
+    SearchExpandedNodes,    // 子を展開した探索ノード数 (フロンティアの平均の分母)
+    SearchFrontierTotal,    // 展開したノードのフロンティアの大きさの合計
+    SearchFrontierMax,      // フロンティアの最大の大きさ
+    Solutions,              // 見つかった解の数 (--symmetry では対称な解の代表だけの数)
+    DuplicateHits,          // 既存の同型類に属すると判明した解の数
+    CoincidentFacesRemoved, // メッシュ構築で削除した接合面の数
+    NautyCalls,             // nauty の呼び出し回数
+    Count
+};
+
+inline const char* phaseName(Phase phase) {
+    static const char* const names[] = {
+        "load", "make_base_graph", "bfs_pruning", "backtracking", "mesh_build", "dual_build", "nauty", "export"
+    };
+    return names[static_cast<int>(phase)];
+}
+
+inline const char* counterName(Counter counter) {
+    static const char* const names[] = {
+        "search_nodes", "search_expanded_nodes", "search_frontier_total", "search_frontier_max",
+        "solutions", "duplicate_hits", "coincident_faces_removed", "nauty_calls"
+    };
+    return names[static_cast<int>(counter)];
+}
+
+// 計時とカウンタの値 (複数スレッドから relaxed で更新する)
+struct RunInstrumentation {
+    std::atomic<long long> phase_ns[static_cast<int>(Phase::Count)] = {};
+    std::atomic<long long> phase_calls[static_cast<int>(Phase::Count)] = {};
+    std::atomic<long long> counters[static_cast<int>(Counter::Count)] = {};
+};
+
+inline RunInstrumentation& runInstrumentation() {
+    static RunInstrumentation instrumentation;
+    return instrumentation;
+}
+
+inline void addCounter(Counter counter, long long value) {
+#if GRADUATION_RESEARCH_INSTRUMENTATION
+    runInstrumentation().counters[static_cast<int>(counter)].fetch_add(value, std::memory_order_relaxed);
+#else
+    (void)counter;
+    (void)value;
+#endif
+}
+
+// カウンタを value との最大値にする
+inline void maxCounter(Counter counter, long long value) {
+#if GRADUATION_RESEARCH_INSTRUMENTATION
+    std::atomic<long long>& slot = runInstrumentation().counters[static_cast<int>(counter)];
+    long long current = slot.load(std::memory_order_relaxed);
+    while (current < value && !slot.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+#else
+    (void)counter;
+    (void)value;
+#endif
+}
+
+inline long long counterValue(Counter counter) {
+    return runInstrumentation().counters[static_cast<int>(counter)].load(std::memory_order_relaxed);
+}
+
+inline double phaseMilliseconds(Phase phase) {
+    return runInstrumentation().phase_ns[static_cast<int>(phase)].load(std::memory_order_relaxed) / 1e6;
+}
+
+inline long long phaseCalls(Phase phase) {
+    return runInstrumentation().phase_calls[static_cast<int>(phase)].load(std::memory_order_relaxed);
+}
+
+#if GRADUATION_RESEARCH_INSTRUMENTATION
+/**
+ * @brief スコープの間の時間を段階 phase に加えるタイマ (同じスレッドの内側のタイマの間は止まる)
+ * stop() で早めに止めることもできます (そのスレッドで一番内側のタイマであるときだけ)。
+ */
+class ScopedPhase {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ScopedPhase(Phase phase) : phase_(phase), parent_(active()) {
+        Clock::time_point now = Clock::now();
+        if (parent_) parent_->accumulate(now);
+        start_ = now;
+        active() = this;
+    }
+
+    ~ScopedPhase() { stop(); }
+
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+    void stop() {
+        if (stopped_) return;
+        stopped_ = true;
+        Clock::time_point now = Clock::now();
+        accumulate(now);
+        runInstrumentation().phase_calls[static_cast<int>(phase_)].fetch_add(1, std::memory_order_relaxed);
+        active() = parent_;
+        if (parent_) parent_->start_ = now; // 外側のタイマを再開
+    }
+
+private:
+    void accumulate(Clock::time_point now) {
+        long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_).count();
+        runInstrumentation().phase_ns[static_cast<int>(phase_)].fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    static ScopedPhase*& active() {
+        static thread_local ScopedPhase* current = nullptr;
+        return current;
+    }
+
+    Phase phase_;
+    ScopedPhase* parent_;
+    Clock::time_point start_;
+    bool stopped_ = false;
+};
+#else
+class ScopedPhase {
+public:
+    explicit ScopedPhase(Phase) {}
+    void stop() {}
+};
+#endif
+
+/**
+ * @brief プロセスの最大常駐メモリ (バイト, 取得できなければ -1)
+ */
+inline long long peakRssBytes() {
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+#if defined(__APPLE__)
+    return static_cast<long long>(usage.ru_maxrss);        // (macOS はバイト単位)
+#else
+    return static_cast<long long>(usage.ru_maxrss) * 1024; // (Linux は KiB 単位)
+#endif
+#else
+    return -1;
+#endif
+}
+
+// ヘルパー: JSON の文字列リテラル
+inline std::string jsonString(const std::string& text) {
+    std::string out = "\"";
+    for (char ch : text) {
+        switch (ch) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(ch) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(ch));
+                    out += escaped;
+                } else {
+                    out += ch;
+                }
+        }
+    }
+    return out + "\"";
+}
+
+/**
+ * @brief 実行の要約を JSON で書き出します (1回の実行につき1つのオブジェクト)。
+ * run_info は実行の設定 (値は書式化済みの JSON: 文字列なら jsonString を使う)、
+ * results は解の数などの結果です。段階の時間・カウンタ・最大常駐メモリはこのファイルの計時から取ります。
+ * build にはビルドの識別子と、コンパイル時の計測・ログの設定を記録します。
+ */
+inline void writeRunSummaryJson(
+    std::ostream& out,
+    const std::vector<std::pair<std::string, std::string>>& run_info,
+    const std::vector<std::pair<std::string, long long>>& results,
+    double wall_ms
+) {
+    const std::ios::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"format\": \"graduation_research.run_summary\",\n  \"version\": 2,\n";
+    out << "  \"build\": {\n    \"id\": " << jsonString(GRADUATION_RESEARCH_BUILD_ID)
+        << ",\n    \"instrumentation\": " << (GRADUATION_RESEARCH_INSTRUMENTATION ? "true" : "false")
+        << ",\n    \"log_max_level\": "
+        << jsonString(logLevelName(static_cast<LogLevel>(
+               std::max(0, std::min(GRADUATION_RESEARCH_LOG_MAX_LEVEL, static_cast<int>(LogLevel::Trace)))))) << "\n  },\n";
+    out << "  \"run\": {";
+    for (size_t i = 0; i < run_info.size(); ++i) {
+        out << (i > 0 ? "," : "") << "\n    " << jsonString(run_info[i].first) << ": " << run_info[i].second;
+    }
+    out << "\n  },\n  \"wall_ms\": " << wall_ms << ",\n  \"phases\": {";
+    for (int p = 0; p < static_cast<int>(Phase::Count); ++p) {
+        Phase phase = static_cast<Phase>(p);
+        out << (p > 0 ? "," : "") << "\n    \"" << phaseName(phase) << "\": {\"ms\": " << phaseMilliseconds(phase)
+            << ", \"calls\": " << phaseCalls(phase) << "}";
+    }
+    out << "\n  },\n  \"counters\": {";
+    for (int c = 0; c < static_cast<int>(Counter::Count); ++c) {
+        Counter counter = static_cast<Counter>(c);
+        out << (c > 0 ? "," : "") << "\n    \"" << counterName(counter) << "\": " << counterValue(counter);
+    }
+    long long expanded = counterValue(Counter::SearchExpandedNodes);
+    out << ",\n    \"search_frontier_mean\": "
+        << (expanded > 0 ? static_cast<double>(counterValue(Counter::SearchFrontierTotal)) / expanded : 0.0);
+    out << ",\n    \"peak_rss_bytes\": " << peakRssBytes();
+    out << "\n  },\n  \"results\": {";
+    for (size_t i = 0; i < results.size(); ++i) {
+        out << (i > 0 ? "," : "") << "\n    " << jsonString(results[i].first) << ": " << results[i].second;
+    }
+    out << "\n  }\n}\n";
+    out.flags(flags);
+    out.precision(precision);
+}
+
+/**
+ * @brief 段階ごとの時間と主なカウンタを人が読む形で書き出します。
+ */
+inline void writePhaseReport(std::ostream& out, double wall_ms) {
+    const std::ios::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+    out << "Phase timings (ms, summed over threads; wall " << wall_ms << " ms):\n";
+    for (int p = 0; p < static_cast<int>(Phase::Count); ++p) {
+        Phase phase = static_cast<Phase>(p);
+        out << "  " << std::left << std::setw(16) << phaseName(phase) << std::right << std::setw(12)
+            << phaseMilliseconds(phase) << "  (" << phaseCalls(phase) << " calls)\n";
+    }
+    out << "Counters:\n";
+    for (int c = 0; c < static_cast<int>(Counter::Count); ++c) {
+        Counter counter = static_cast<Counter>(c);
+        out << "  " << std::left << std::setw(26) << counterName(counter) << std::right << counterValue(counter) << '\n';
+    }
+    out << "  " << std::left << std::setw(26) << "peak_rss_bytes" << std::right << peakRssBytes() << std::endl;
+    out.flags(flags);
+    out.precision(precision);
+}
+
+#endif // INSTRUMENTATION_HPP
@@ -0,0 +1,82 @@
+#ifndef INT_GRAPH_HPP
+#define INT_GRAPH_HPP
+
+#include <vector>
+#include <string>
+#include <utility>
+#include <functional>
+#include <cstdint>
+
+#include "tdzdd/util/Graph.hpp"
+#include "1_core_graph/CsrGraph.hpp"
+#include "1_core_graph/GridHashMap.hpp"
+
+/**
+ * @brief 整数IDの無向グラフ (辺リスト表現)
+ * tdzdd::Graph と同じく「辺に現れる頂点」だけをグラフの頂点とみなしますが、
+ * 頂点名 (文字列) は持たず、頂点ID は 0 .. idBound()-1 の整数です。
+ * 各辺は (先に現れた頂点, 後に現れた頂点) の向きで、重複なく追加順に並びます。
+ */
+struct IntGraph {
+    int id_bound = 0;                             // 頂点IDの上限 (この値未満)
+    int num_vertices = 0;                         // 辺に現れる頂点の数
+    std::vector<std::pair<int, int>> edges;       // 辺 (重複なし, 追加順)
+
+    int idBound() const { return id_bound; }
+    int vertexSize() const { return num_vertices; }
+    int edgeSize() const { return static_cast<int>(edges.size()); }
+};
+
+/**
+ * @brief 辺リストから IntGraph を一括構築します (頂点ID は [0, id_bound) の範囲)。
+ * 自己ループと重複辺 (向きを問わない) は取り除き、最初に現れた辺だけを残します。
+ */
+inline IntGraph buildIntGraph(int id_bound, const std::vector<std::pair<int, int>>& edges) {
+    IntGraph g;
+    g.id_bound = id_bound;
+    g.edges.reserve(edges.size());
+
+    std::vector<int> first_seen(id_bound, -1); // 頂点ID -> 初出順
+    OpenAddressingMap<uint64_t, bool, UInt64Hasher> seen_edges(edges.size());
+    for (const auto& edge : edges) {
+        int u = edge.first;
+        int v = edge.second;
+        if (u == v) continue;
+        if (first_seen[u] < 0) first_seen[u] = g.num_vertices++;
+        if (first_seen[v] < 0) first_seen[v] = g.num_vertices++;
+        if (first_seen[u] > first_seen[v]) std::swap(u, v);
+        uint64_t key = (static_cast<uint64_t>(u) << 32) | static_cast<uint32_t>(v);
+        if (!seen_edges.tryEmplace(key, true).second) continue;
+        g.edges.push_back({u, v});
+    }
+    return g;
+}
+
+/**
+ * @brief IntGraph を CSR 表現に変換します (type_id は頂点ID -> タイプID)。
+ */
+inline CsrGraph toCsrGraph(const IntGraph& g, std::vector<int> type_id) {
+    return buildCsrGraph(g.id_bound, g.edges, std::move(type_id));
+}
+
+// ヘルパー: 頂点ID をそのまま10進文字列にする頂点名 (双対グラフの面番号など)
+inline std::string integerVertexName(int vertex_id) {
+    return std::to_string(vertex_id);
+}
+
+/**
+ * @brief tdzdd の機能 (ZDD 構築など) が必要な場合にだけ、頂点名付きの tdzdd::Graph に変換します。
+ */
+inline tdzdd::Graph toTdzddGraph(
+    const IntGraph& g,
+    const std::function<std::string(int)>& vertex_name = integerVertexName
+) {
+    tdzdd::Graph named_graph;
+    for (const auto& edge : g.edges) {
+        named_graph.addEdge(vertex_name(edge.first), vertex_name(edge.second));
+    }
+    named_graph.update();
+    return named_graph;
+}
+
+#endif // INT_GRAPH_HPP
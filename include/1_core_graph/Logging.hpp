@@ -0,0 +1,131 @@
+#ifndef LOGGING_HPP
+#define LOGGING_HPP
+
+#include <atomic>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <cstdint>
+
+// --- レベル付きのログ ---
+// 各関数は従来どおり std::ostream& log_stream を受け取り、書き込む行ごとにレベルとサブシステムを指定します。
+//   GR_LOG(log_stream, LogLevel::Debug, LogSubsystem::Search, "  [DEBUG] ... " << value << '\n');
+// 書式化 (<< の右辺の評価) はそのレベルとサブシステムが有効なときだけ行われます。
+// 行末は std::endl ではなく '\n' とし、フラッシュは段階の区切り (探索の終わりなど) で呼び出し側がまとめて行います。
+// GRADUATION_RESEARCH_LOG_MAX_LEVEL より詳細なレベルの行はコンパイル時に消えます
+// (既定: NDEBUG 付きのリリースビルドでは Info まで、それ以外は Trace まで)。
+// 実行時のレベルとサブシステムの有効・無効は setLogLevel / setLogSubsystems で切り替えます
+// (探索や後処理のスレッドを起動する前に設定すること)。
+
+enum class LogLevel : int {
+    Error = 0,
+    Warning = 1,
+    Info = 2,    // 段階ごとの進捗と集計 (既定)
+    Debug = 3,   // 解ごとのメッセージ, G'/G'' の頂点リストなど
+    Trace = 4    // 格子のコア配置と接続の1行ずつのログなど
+};
+
+enum class LogSubsystem : int {
+    Lattice = 0,  // 格子生成 (make_base_graph) と定義ファイル
+    Search,       // G'/G'' の構築と探索
+    Symmetry,     // 対称性枝刈り
+    Geometry,     // 解のメッシュ構築
+    Analysis,     // 双対グラフと同型判定
+    Export,       // ファイル出力
+    Count
+};
+
+#ifndef GRADUATION_RESEARCH_LOG_MAX_LEVEL
+#ifdef NDEBUG
+#define GRADUATION_RESEARCH_LOG_MAX_LEVEL 2
+#else
+#define GRADUATION_RESEARCH_LOG_MAX_LEVEL 4
+#endif
+#endif
+
+// 実行時の設定 (レベルとサブシステムのビットマスク)
+struct LogConfig {
+    std::atomic<int> level{static_cast<int>(LogLevel::Info)};
+    std::atomic<uint32_t> subsystems{(1u << static_cast<int>(LogSubsystem::Count)) - 1};
+};
+
+inline LogConfig& logConfig() {
+    static LogConfig config;
+    return config;
+}
+
+inline void setLogLevel(LogLevel level) {
+    logConfig().level.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+inline void setLogSubsystems(uint32_t mask) {
+    logConfig().subsystems.store(mask, std::memory_order_relaxed);
+}
+
+/**
+ * @brief そのレベルとサブシステムのログが実行時に有効か (コンパイル時の上限は GR_LOG_ENABLED で判定)
+ */
+inline bool logEnabled(LogLevel level, LogSubsystem subsystem) {
+    const LogConfig& config = logConfig();
+    return static_cast<int>(level) <= config.level.load(std::memory_order_relaxed) &&
+           (config.subsystems.load(std::memory_order_relaxed) >> static_cast<int>(subsystem) & 1u) != 0;
+}
+
+// ヘルパー: レベル -> 名前 (コマンドラインと同じ綴り)
+inline const char* logLevelName(LogLevel level) {
+    static const char* const names[] = {"error", "warning", "info", "debug", "trace"};
+    return names[static_cast<int>(level)];
+}
+
+inline LogLevel currentLogLevel() {
+    return static_cast<LogLevel>(logConfig().level.load(std::memory_order_relaxed));
+}
+
+// ヘルパー: 名前 -> レベル・サブシステム (コマンドライン用, 不明なら false)
+inline bool parseLogLevel(const std::string& name, LogLevel& level) {
+    for (int i = 0; i <= static_cast<int>(LogLevel::Trace); ++i) {
+        if (name == logLevelName(static_cast<LogLevel>(i))) {
+            level = static_cast<LogLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+inline bool parseLogSubsystem(const std::string& name, LogSubsystem& subsystem) {
+    static const char* const names[] = {"lattice", "search", "symmetry", "geometry", "analysis", "export"};
+    for (int i = 0; i < static_cast<int>(LogSubsystem::Count); ++i) {
+        if (name == names[i]) {
+            subsystem = static_cast<LogSubsystem>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 何も書き出さないストリーム (ログを捨てる呼び出し先に渡す, スレッドごとに1つ)
+ */
+inline std::ostream& nullLogStream() {
+    struct NullBuffer : std::streambuf {
+        int overflow(int ch) override { return ch; }
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+    };
+    static thread_local NullBuffer buffer;
+    static thread_local std::ostream stream(&buffer);
+    return stream;
+}
+
+// コンパイル時の上限と実行時の設定の両方で有効か
+#define GR_LOG_ENABLED(level, subsystem) \
+    (static_cast<int>(level) <= GRADUATION_RESEARCH_LOG_MAX_LEVEL && logEnabled((level), (subsystem)))
+
+// 有効なときだけ stream << message を評価する
+#define GR_LOG(stream, level, subsystem, message) \
+    do { \
+        if (GR_LOG_ENABLED(level, subsystem)) { \
+            (stream) << message; \
+        } \
+    } while (0)
+
+#endif // LOGGING_HPP
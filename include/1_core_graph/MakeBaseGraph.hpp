@@ -10,9 +10,16 @@
 #include <fstream>
 #include <cmath> 
 #include <ostream> // <-- 【追加】 std::ostream のため
+#include <algorithm>
+#include <cstdint>
 #include <tdzdd/util/MessageHandler.hpp>
 #include <tdzdd/util/Graph.hpp>
 
+#include "1_core_graph/GridHashMap.hpp"
+#include "1_core_graph/IntGraph.hpp"
+#include "1_core_graph/Instrumentation.hpp"
+#include "1_core_graph/Logging.hpp"
+
 // 座標をdouble型で扱う
 struct Point3D {
     double x, y, z;
@@ -30,6 +37,9 @@ struct GridPoint3D {
     bool operator<(const GridPoint3D& other) const {
         return std::tie(x_grid, y_grid, z_grid) < std::tie(other.x_grid, other.y_grid, other.z_grid);
     }
+    bool operator==(const GridPoint3D& other) const {
+        return x_grid == other.x_grid && y_grid == other.y_grid && z_grid == other.z_grid;
+    }
 };
 
 // 【新設】double座標をグリッド座標に変換するヘルパー関数
@@ -51,94 +61,186 @@ struct ConnectionRule {
     std::vector<std::pair<std::string, std::string>> connections;
 };
 
+/**
+ * @brief ベースグラフ (格子) の生成結果
+ * 格子上の頂点は整数ID (コアID * タイプ数 + タイプ番号) で表し、
+ * 頂点名 ("12_b" など) は必要になった時点で生成します。
+ */
 struct GraphData {
-    tdzdd::Graph full_graph;
-    std::map<int, Point3D> core_locations; // コアの座標はdoubleで保持
-    std::set<std::pair<int, int>> core_connectivity;
+    IntGraph full_graph; // 格子全体のグラフ (整数頂点ID)
+    std::vector<Point3D> core_locations; // コアID -> 座標 (コアIDは 0 からの連番, 座標はdoubleで保持)
+    std::vector<std::pair<int, int>> core_connectivity; // コア間接続 (id1 < id2, 昇順)
+    std::vector<std::string> vertex_types;             // タイプ番号 -> タイプ名
+};
+
+// make_base_graph が作る格子の版数 (コアの並び・頂点ID・辺など、結果が変わる変更をしたら1つ上げること)
+// コンパイル済みキャッシュに記録し、版数の違う格子は使いません (DefinitionCache.hpp)。
+constexpr uint64_t kBaseGraphGeneratorVersion = 1;
+
+/**
+ * @brief make_base_graph のオプション
+ */
+struct BaseGraphOptions {
+    bool log_placements = true;    // コアの配置と接続を1行ずつログに出す (Trace レベルで Lattice が有効なときだけ)
 };
 
-// --- ▼ 【修正】 関数シグネチャと std::cerr -> log_stream ▼ ---
+// GridPoint3D 用のハッシュ (各軸を攪拌して合成)
+struct GridPointHasher {
+    uint64_t operator()(const GridPoint3D& p) const {
+        uint64_t h = mixHash64(static_cast<uint64_t>(p.x_grid));
+        h = mixHash64(h ^ static_cast<uint64_t>(p.y_grid));
+        return mixHash64(h ^ static_cast<uint64_t>(p.z_grid));
+    }
+};
+
+// ヘルパー: 整数頂点ID -> 頂点名 ("ID_TYPE")
+inline std::string baseVertexName(const GraphData& data, int vertex_id) {
+    int num_types = static_cast<int>(data.vertex_types.size());
+    return std::to_string(vertex_id / num_types) + "_" + data.vertex_types[vertex_id % num_types];
+}
+
+// ヘルパー: 頂点名 ("ID_TYPE") -> 整数頂点ID (格子に無い頂点なら -1)
+inline int findBaseVertex(const GraphData& data, const std::string& vertex_name) {
+    size_t underscore = vertex_name.find('_');
+    if (underscore == std::string::npos || underscore == 0) return -1;
+    long long core_id = 0;
+    for (size_t i = 0; i < underscore; ++i) {
+        char ch = vertex_name[i];
+        if (ch < '0' || ch > '9') return -1;
+        core_id = core_id * 10 + (ch - '0');
+        if (core_id >= static_cast<long long>(data.core_locations.size())) return -1;
+    }
+    std::string type_name = vertex_name.substr(underscore + 1);
+    for (size_t t = 0; t < data.vertex_types.size(); ++t) {
+        if (data.vertex_types[t] == type_name) {
+            return static_cast<int>(core_id * data.vertex_types.size() + t);
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief 頂点名付きの tdzdd::Graph が必要な場合にだけ、full_graph を変換します。
+ */
+inline tdzdd::Graph namedBaseGraph(const GraphData& data) {
+    return toTdzddGraph(data.full_graph, [&data](int v) { return baseVertexName(data, v); });
+}
+
+/**
+ * @brief 接続規則に従って原点から n 段まで格子を広げ、ベースグラフを生成します。
+ * 座標 -> コアID の対応は量子化座標をキーとする開番地法のハッシュマップで引くため、
+ * 規則の適用1回あたりの検索は (期待値で) 定数時間です。
+ */
 inline GraphData make_base_graph(
     const CoreGraph& core_graph,
     const std::vector<ConnectionRule>& rules,
     int n,
-    std::ostream& log_stream // <-- 【追加】
+    std::ostream& log_stream,
+    const BaseGraphOptions& options = BaseGraphOptions()
 ){
+    ScopedPhase phase(Phase::BaseGraph);
     GraphData data; 
-    std::map<GridPoint3D, int> coord_to_core_id; 
-    std::vector<Point3D> frontier_coords; 
-    int next_core_id = 0; 
 
-    Point3D origin_double = {0, 0, 0}; 
-    GridPoint3D origin_grid = quantize(origin_double); 
-    int origin_core_id = next_core_id++; 
-
-    coord_to_core_id[origin_grid] = origin_core_id; 
-    frontier_coords.push_back(origin_double); 
-    data.core_locations[origin_core_id] = origin_double; 
-
-    log_stream << "Placed core " << origin_core_id << " at (0, 0, 0)" << std::endl;
+    // 1. タイプ名 -> タイプ番号 (コアグラフの頂点順。規則にしか現れないタイプは末尾に追加)
+    std::map<std::string, int> type_to_index;
+    for (int v = 1; v <= core_graph.vertexSize(); ++v) {
+        if (type_to_index.emplace(core_graph.vertexName(v), data.vertex_types.size()).second) {
+            data.vertex_types.push_back(core_graph.vertexName(v));
+        }
+    }
+    auto typeIndex = [&](const std::string& type_name) {
+        auto inserted = type_to_index.emplace(type_name, data.vertex_types.size());
+        if (inserted.second) data.vertex_types.push_back(type_name);
+        return inserted.first->second;
+    };
+    std::vector<std::pair<int, int>> core_edges; // コア内の辺 (タイプ番号の組)
     for (int i = 0; i < core_graph.edgeSize(); ++i) {
         const auto& edge = core_graph.edgeInfo(i);
-        std::string u_name = std::to_string(origin_core_id) + "_" + core_graph.vertexName(edge.v1);
-        std::string v_name = std::to_string(origin_core_id) + "_" + core_graph.vertexName(edge.v2);
-        data.full_graph.addEdge(u_name, v_name);
-        log_stream << "  Connecting " << u_name << " to " << v_name << std::endl;
+        core_edges.push_back({typeIndex(core_graph.vertexName(edge.v1)), typeIndex(core_graph.vertexName(edge.v2))});
+    }
+    std::vector<std::vector<std::pair<int, int>>> rule_edges(rules.size()); // 規則ごとのコア間の辺 (タイプ番号の組)
+    for (size_t r = 0; r < rules.size(); ++r) {
+        for (const auto& conn : rules[r].connections) {
+            rule_edges[r].push_back({typeIndex(conn.first), typeIndex(conn.second)});
+        }
     }
+    const int num_types = static_cast<int>(data.vertex_types.size());
+    std::vector<std::pair<int, int>> vertex_edges; // 整数頂点IDの辺 (生成順)
+    const bool log_placements = options.log_placements && GR_LOG_ENABLED(LogLevel::Trace, LogSubsystem::Lattice);
+
+    // ヘルパー: 新しいコアを配置し、コア内の辺を追加
+    auto placeCore = [&](int core_id, const Point3D& coord) {
+        data.core_locations.push_back(coord);
+        if (log_placements) {
+            log_stream << "Placed core " << core_id << " at ("
+                       << coord.x << ", " << coord.y << ", " << coord.z << ")" << '\n';
+        }
+        for (const auto& edge : core_edges) {
+            vertex_edges.push_back({core_id * num_types + edge.first, core_id * num_types + edge.second});
+            if (log_placements) {
+                log_stream << "  Connecting " << core_id << "_" << data.vertex_types[edge.first]
+                           << " to " << core_id << "_" << data.vertex_types[edge.second] << '\n';
+            }
+        }
+    };
+
+    OpenAddressingMap<GridPoint3D, int, GridPointHasher> coord_to_core_id;
+    OpenAddressingMap<uint64_t, bool, UInt64Hasher> connected_pairs;
+    std::vector<std::pair<int, Point3D>> frontier; // (コアID, 座標)
+    int next_core_id = 0; 
+
+    Point3D origin_double = {0, 0, 0}; 
+    int origin_core_id = next_core_id++; 
+    coord_to_core_id.tryEmplace(quantize(origin_double), origin_core_id);
+    frontier.push_back({origin_core_id, origin_double});
+    placeCore(origin_core_id, origin_double);
 
     for (int i = 0; i < n; ++i) {
-        std::vector<Point3D> next_frontier_coords; 
-        for (const auto& current_coord_double : frontier_coords) {
-            GridPoint3D current_coord_grid = quantize(current_coord_double); 
-            int current_core_id = coord_to_core_id.at(current_coord_grid);
-
-            for (const auto& rule : rules) {
-                Point3D next_coord_double = current_coord_double + rule.vector; 
-                GridPoint3D next_coord_grid = quantize(next_coord_double);   
-                int destination_core_id; 
-
-                if (coord_to_core_id.count(next_coord_grid)) {
-                    destination_core_id = coord_to_core_id.at(next_coord_grid);
-                } else {
-                    destination_core_id = next_core_id++; 
-                    coord_to_core_id[next_coord_grid] = destination_core_id; 
-                    next_frontier_coords.push_back(next_coord_double); 
-                    data.core_locations[destination_core_id] = next_coord_double; 
-
-                    log_stream << "Placed core " << destination_core_id << " at ("
-                              << next_coord_double.x << ", " << next_coord_double.y << ", " << next_coord_double.z << ")" << std::endl;
-                    for (int j = 0; j < core_graph.edgeSize(); ++j) {
-                        const auto& edge = core_graph.edgeInfo(j);
-                        std::string u_name = std::to_string(destination_core_id) + "_" + core_graph.vertexName(edge.v1);
-                        std::string v_name = std::to_string(destination_core_id) + "_" + core_graph.vertexName(edge.v2);
-                        data.full_graph.addEdge(u_name, v_name);
-                        log_stream << "  Connecting " << u_name << " to " << v_name << std::endl;
-                    }
+        std::vector<std::pair<int, Point3D>> next_frontier; 
+        for (const auto& current : frontier) {
+            int current_core_id = current.first;
+            const Point3D& current_coord_double = current.second;
+
+            for (size_t r = 0; r < rules.size(); ++r) {
+                Point3D next_coord_double = current_coord_double + rules[r].vector; 
+
+                // 既存のコアならそのIDを、無ければ新しいIDを割り当てる (検索は1回だけ)
+                auto found = coord_to_core_id.tryEmplace(quantize(next_coord_double), next_core_id);
+                int destination_core_id = found.first;
+                if (found.second) {
+                    next_core_id++;
+                    next_frontier.push_back({destination_core_id, next_coord_double});
+                    placeCore(destination_core_id, next_coord_double);
                 }
 
                 int id1 = std::min(current_core_id, destination_core_id);
                 int id2 = std::max(current_core_id, destination_core_id);
-                if (id1 == id2 || data.core_connectivity.count({id1, id2})) {
-                    continue;
-                }
-                data.core_connectivity.insert({id1, id2});
-
-                for (const auto& conn : rule.connections) {
-                    std::string u_name = std::to_string(current_core_id) + "_" + conn.first;
-                    std::string v_name = std::to_string(destination_core_id) + "_" + conn.second;
-                    data.full_graph.addEdge(u_name, v_name);
-                    log_stream << "  Connecting " << u_name << " to " << v_name << std::endl;
+                if (id1 == id2) continue;
+                uint64_t pair_key = (static_cast<uint64_t>(id1) << 32) | static_cast<uint32_t>(id2);
+                if (!connected_pairs.tryEmplace(pair_key, true).second) continue;
+                data.core_connectivity.push_back({id1, id2});
+
+                for (const auto& edge : rule_edges[r]) {
+                    vertex_edges.push_back({current_core_id * num_types + edge.first,
+                                                 destination_core_id * num_types + edge.second});
+                    if (log_placements) {
+                        log_stream << "  Connecting " << current_core_id << "_" << data.vertex_types[edge.first]
+                                   << " to " << destination_core_id << "_" << data.vertex_types[edge.second] << '\n';
+                    }
                 }
             } 
         } 
 
-        frontier_coords = next_frontier_coords;
-        if (frontier_coords.empty()) break;
+        frontier.swap(next_frontier);
+        if (frontier.empty()) break;
     } 
 
-    data.full_graph.update();
+    std::sort(data.core_connectivity.begin(), data.core_connectivity.end());
+    data.full_graph = buildIntGraph(static_cast<int>(data.core_locations.size()) * num_types, vertex_edges);
+    GR_LOG(log_stream, LogLevel::Info, LogSubsystem::Lattice,
+           "Base graph: " << data.core_locations.size() << " cores, " << data.full_graph.edgeSize() << " edges." << '\n');
+    log_stream.flush(); // (格子生成の段階の区切り)
     return data;
 }
-// --- ▲ 【修正】 ▲ ---
 
-#endif // MAKE_BASE_GRAPH_HPP
\ No newline at end of file
+#endif // MAKE_BASE_GRAPH_HPP
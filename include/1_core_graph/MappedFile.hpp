@@ -0,0 +1,74 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cstddef>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GRADUATION_RESEARCH_HAS_MMAP 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief 読み取り専用でメモリにマップしたファイル (RAII)
+ * mmap が使えない環境や空のファイルでは、ファイル全体をメモリに読み込んで代用します。
+ * data() の内容は、このオブジェクトが生きている間だけ有効です。
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename) {
+#ifdef GRADUATION_RESEARCH_HAS_MMAP
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Error: Cannot open file: " + filename);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* mapped = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                data_ = static_cast<const char*>(mapped);
+                size_ = static_cast<size_t>(st.st_size);
+                mapped_ = true;
+            }
+        }
+        ::close(fd);
+        if (mapped_) return;
+#endif
+        // mmap できない場合は読み込んで代用
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Error: Cannot open file: " + filename);
+        }
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        buffer_ = contents.str();
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+    }
+
+    ~MappedFile() {
+#ifdef GRADUATION_RESEARCH_HAS_MMAP
+        if (mapped_) ::munmap(const_cast<char*>(data_), size_);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::string buffer_; // (mmap を使わない場合の中身)
+};
+
+#endif // MAPPED_FILE_HPP
@@ -0,0 +1,17 @@
+#ifndef NAUTY_LOCK_HPP
+#define NAUTY_LOCK_HPP
+
+#include <mutex>
+
+/**
+ * @brief nauty の呼び出しを直列化するミューテックス
+ * nauty は TLS 対応でビルドした場合 (nauty.h で USE_TLS が定義される) のみスレッド安全なので、
+ * それ以外では複数スレッドから同時に呼ばないようにします。
+ * (探索の対称性検出と同型判定の両方が使うので、どちらの層からも見える場所に置く)
+ */
+inline std::mutex& nautyMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+#endif // NAUTY_LOCK_HPP
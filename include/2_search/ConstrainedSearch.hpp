@@ -6,11 +6,17 @@
 #include <vector>
 #include <list>
 #include <map>
-#include <queue> // BFSのために追加
 #include <iostream>
 #include <stdexcept>
+#include <functional>
+#include <algorithm>
 #include "1_core_graph/MakeBaseGraph.hpp" 
-#include "tdzdd/util/Graph.hpp" 
+#include "1_core_graph/CsrGraph.hpp"
+#include "1_core_graph/Instrumentation.hpp"
+#include "1_core_graph/Logging.hpp"
+#include "2_search/IndexedSearch.hpp"
+#include "2_search/ParallelSearch.hpp"
+#include "2_search/SearchSymmetry.hpp"
 
 // ヘルパー: 頂点名 (例: "0_a") からベースタイプ (例: "a") を抽出
 inline std::string getBaseType(const std::string& full_name) {
@@ -19,195 +25,153 @@ inline std::string getBaseType(const std::string& full_name) {
     return full_name.substr(underscore + 1);
 }
 
-// ヘルパー: G' (0_a 以外の 'a' タイプを除外した) グラフを構築
-inline std::map<std::string, std::set<std::string>> buildFilteredAdjacencyList(
-    tdzdd::Graph& original_graph, 
-    const std::string& root_name
+/**
+ * @brief ベースグラフ (整数頂点ID) から前処理用の CSR グラフ G を構築します。
+ * CSR の頂点ID は格子の整数頂点ID、タイプID は type_names 内の位置 (該当なしは -1) です。
+ */
+inline CsrGraph buildCsrFromGraph(
+    const GraphData& base_data,
+    const std::vector<std::string>& type_names
 ) {
-    std::map<std::string, std::set<std::string>> adj_list;
-    std::set<std::string> valid_vertices; 
-    std::string root_type = getBaseType(root_name);
-
-    if (root_type.empty()) {
-        throw std::runtime_error("Root name is invalid (no type): " + root_name);
-    }
-
-    // G' に含まれるべき頂点を定義
-    for (int i = 1; i <= original_graph.vertexSize(); ++i) {
-        std::string v_name = original_graph.vertexName(i);
-        std::string v_type = getBaseType(v_name);
-        
-        // root_type (例: 'a') と同じタイプだが、root_name (例: '0_a') 自身ではない頂点は除外
-        if (v_type == root_type && v_name != root_name) {
-            continue; 
+    // 格子のタイプ番号 -> 探索のタイプID
+    std::vector<int> lattice_type_to_id(base_data.vertex_types.size(), -1);
+    for (size_t t = 0; t < base_data.vertex_types.size(); ++t) {
+        auto it = std::lower_bound(type_names.begin(), type_names.end(), base_data.vertex_types[t]);
+        if (it != type_names.end() && *it == base_data.vertex_types[t]) {
+            lattice_type_to_id[t] = static_cast<int>(it - type_names.begin());
         }
-        valid_vertices.insert(v_name);
     }
-
-    // G' の隣接リストを構築
-    for (int i = 0; i < original_graph.edgeSize(); ++i) {
-        const auto& edge = original_graph.edgeInfo(i);
-        std::string u_name = original_graph.vertexName(edge.v1);
-        std::string v_name = original_graph.vertexName(edge.v2);
-
-        // 両方の頂点が G' に含まれるエッジのみを追加
-        if (valid_vertices.count(u_name) && valid_vertices.count(v_name)) {
-            adj_list[u_name].insert(v_name);
-            adj_list[v_name].insert(u_name);
-        }
+    int num_lattice_types = static_cast<int>(base_data.vertex_types.size());
+    std::vector<int> type_id(base_data.full_graph.idBound(), -1);
+    for (size_t v = 0; v < type_id.size(); ++v) {
+        type_id[v] = lattice_type_to_id[v % num_lattice_types];
     }
-    return adj_list;
+    return toCsrGraph(base_data.full_graph, std::move(type_id));
 }
 
-// 【新設】 ヘルパー: BFSで始点からのホップ数を計算
-inline std::map<std::string, int> calculateDistancesBFS(
-    const std::string& start_node,
-    const std::map<std::string, std::set<std::string>>& adj_list
+// ヘルパー: G' (0_a 以外の 'a' タイプを除外した) グラフを頂点マスクとして構築
+inline VertexMask buildFilteredVertexMask(
+    const GraphData& base_data,
+    int root_index
 ) {
-    std::map<std::string, int> distances;
-    std::queue<std::pair<std::string, int>> q;
+    int num_lattice_types = static_cast<int>(base_data.vertex_types.size());
+    int root_type = root_index % num_lattice_types;
 
-    if (adj_list.count(start_node) == 0) {
-        return distances; // 始点がグラフに存在しない
+    VertexMask mask(base_data.full_graph.idBound(), 1);
+    for (size_t v = root_type; v < mask.size(); v += num_lattice_types) {
+        // root_type (例: 'a') と同じタイプだが、root (例: '0_a') 自身ではない頂点は除外
+        if (static_cast<int>(v) != root_index) mask[v] = 0;
     }
+    return mask;
+}
 
-    q.push({start_node, 0});
-    distances[start_node] = 0;
-
-    while (!q.empty()) {
-        std::string current_node = q.front().first;
-        int current_dist = q.front().second;
-        q.pop();
-
-        // adj_list.at() は .count() チェック済みの想定
-        if (adj_list.count(current_node) == 0) continue; 
-
-        for (const std::string& neighbor : adj_list.at(current_node)) {
-            // 未訪問 (distances にキーがない) なら距離を記録してキューに追加
-            if (distances.find(neighbor) == distances.end()) {
-                distances[neighbor] = current_dist + 1;
-                q.push({neighbor, current_dist + 1});
-            }
+// ヘルパー: G' のマスクを G'' (max_distance = n-1 ホップ以内) のマスクに絞り込む
+inline VertexMask filterMaskByDistance(
+    const VertexMask& mask_G_prime,
+    const std::vector<int>& distances,
+    int max_distance
+) {
+    VertexMask mask_G_double_prime(mask_G_prime.size(), 0);
+    for (size_t v = 0; v < mask_G_prime.size(); ++v) {
+        if (mask_G_prime[v] && distances[v] >= 0 && distances[v] <= max_distance) {
+            mask_G_double_prime[v] = 1;
         }
     }
-    return distances;
+    return mask_G_double_prime;
 }
 
-// 【新設】 ヘルパー: G' を G'' にフィルタリング (n-1 ホップ以内)
-inline std::map<std::string, std::set<std::string>> filterGraphByDistance(
-    const std::map<std::string, std::set<std::string>>& adj_list_G_prime,
-    const std::map<std::string, int>& distances,
-    int max_distance // (n-1) が渡される
+/**
+ * @brief マスク付き CSR グラフ (G'') から IndexedSearchGraph を構築します。
+ * マスク内に辺を1本以上持つ頂点だけを詰め直し、頂点IDは頂点名の昇順に割り当てるため、結果は実行ごとに決定的です。
+ */
+inline IndexedSearchGraph buildIndexedSearchGraph(
+    const CsrGraph& base,
+    const std::function<std::string(int)>& vertex_name,
+    const VertexMask& mask,
+    int num_types
 ) {
-    std::map<std::string, std::set<std::string>> adj_list_G_double_prime;
-    std::set<std::string> valid_nodes_in_G_double_prime;
+    IndexedSearchGraph g;
 
-    // 1. max_distance (n-1) 以内の頂点をすべて特定
-    for (const auto& pair : distances) {
-        if (pair.second <= max_distance) {
-            valid_nodes_in_G_double_prime.insert(pair.first);
-        }
+    // 1. 元の頂点ID -> 探索用頂点ID (頂点名順, 頂点名は G'' の頂点の分だけ生成)
+    std::vector<std::pair<std::string, int>> members;
+    for (int v = 0; v < base.vertexSize(); ++v) {
+        if (hasMaskedNeighbor(base, mask, v)) members.push_back({vertex_name(v), v});
+    }
+    std::sort(members.begin(), members.end());
+    std::vector<int> to_local(base.vertexSize(), -1);
+    std::vector<int> type_id(members.size(), -1);
+    g.names.reserve(members.size());
+    for (size_t i = 0; i < members.size(); ++i) {
+        to_local[members[i].second] = static_cast<int>(i);
+        g.names.push_back(std::move(members[i].first));
+        type_id[i] = base.type_id[members[i].second];
     }
 
-    // 2. G' (adj_list_G_prime) を走査し、G'' にエッジを追加
-    for (const auto& pair : adj_list_G_prime) {
-        const std::string& u = pair.first;
-        
-        // そもそも u が G'' に含まれない頂点ならスキップ
-        if (valid_nodes_in_G_double_prime.count(u) == 0) continue;
-
-        // u は G'' に含まれる。隣接頂点 v をチェック
-        for (const std::string& v : pair.second) {
-            // v も G'' に含まれるなら、G'' の隣接リストに追加
-            if (valid_nodes_in_G_double_prime.count(v)) {
-                adj_list_G_double_prime[u].insert(v);
-            }
+    // 2. タイプごとのビットセット
+    g.num_types = num_types;
+    g.type_masks.assign(g.num_types, DynamicBitset(g.names.size()));
+    for (size_t v = 0; v < type_id.size(); ++v) {
+        if (type_id[v] >= 0) g.type_masks[type_id[v]].set(v);
+    }
+
+    // 3. 隣接構造 (CSR, 両端がマスク内の辺のみ)
+    std::vector<std::pair<int, int>> edges;
+    for (const auto& member : members) {
+        int u = member.second;
+        for (int v : base.neighbors(u)) {
+            if (u < v && mask[v]) edges.push_back({to_local[u], to_local[v]});
         }
     }
-    
-    return adj_list_G_double_prime;
+    g.graph = buildCsrGraph(static_cast<int>(members.size()), edges, std::move(type_id));
+    return g;
 }
 
-
 /**
- * @brief 再帰的なバックトラッキング関数 (アルゴリズムのコア)
- * (変更なし)
+ * @brief 探索の実行オプション
  */
-void findSolutionsRecursive(
-    std::set<std::string>& current_path,            
-    std::set<std::string>& types_collected,         
-    const std::set<std::string>& frontier,          
-    std::set<std::set<std::string>>& all_solutions, // (set に変更済み)
-    const std::map<std::string, std::set<std::string>>& adj_list, 
-    const std::set<std::string>& all_types          
-) {
-    // 1. 成功のベースケース
-    if (types_collected.size() == all_types.size()) {
-        all_solutions.insert(current_path); // (insert に変更済み)
-        return; 
-    }
+struct SearchOptions {
+    int num_threads = 1; // 1 なら逐次探索
+    int split_depth = 2; // 並列探索時、探索木をタスクに分割する深さ
 
-    // 2. 失敗のベースケース
-    if (frontier.empty()) {
-        return; 
-    }
+    // 対称性枝刈り: G'' の自己同型のうち symmetry_validator が幾何的に正当と認めたものを使い、
+    // 対称な解は (少なくとも) 1つの代表だけを出力する
+    bool use_symmetry = false;
+    CoreMapValidator symmetry_validator;
 
-    // 3. 再帰ステップ
-    for (const std::string& next_vertex : frontier) {
-        
-        std::string v_type = getBaseType(next_vertex);
+    // 増分処理: 探索パスの変化を通知するオブザーバの生成関数 (逐次探索では1つ, 並列探索ではワーカーごとに1つ作る)
+    SearchPathObserverFactory path_observer_factory;
+};
 
-        // すでに収集済みのタイプは無視
-        if (v_type.empty() || types_collected.count(v_type)) {
-            continue;
-        }
-        
-        // (A) 選択
-        current_path.insert(next_vertex);
-        types_collected.insert(v_type);
-
-        // (B) 新しいフロンティアを計算
-        std::set<std::string> new_frontier = frontier;
-        new_frontier.erase(next_vertex); 
-
-        if (adj_list.count(next_vertex)) { 
-            const auto& new_neighbors = adj_list.at(next_vertex);
-            for (const std::string& n : new_neighbors) {
-                if (current_path.count(n) == 0) { // まだパスに含まれていない隣人
-                    new_frontier.insert(n);
-                }
-            }
-        }
-        
-        // (C) フロンティアをフィルタリング (収集済みタイプはフロンティアから除外)
-        std::set<std::string> filtered_frontier;
-        for (const std::string& v_f : new_frontier) {
-            std::string f_type = getBaseType(v_f);
-            if (f_type.empty() || !types_collected.count(f_type)) {
-                filtered_frontier.insert(v_f);
-            }
-        }
+/**
+ * @brief 探索の統計情報
+ */
+struct SearchStats {
+    long long nodes_visited = 0;   // 訪問した探索ノード数
+    long long symmetry_pruned = 0; // 対称性により枝刈りした子ノード数
+    size_t num_solutions = 0;      // 見つかった解の数 (use_symmetry なら対称な解の代表だけの数)
+};
 
-        // (D) 再帰
-        findSolutionsRecursive(current_path, types_collected, filtered_frontier, all_solutions, adj_list, all_types);
-
-        // (E) バックトラック
-        current_path.erase(next_vertex);
-        types_collected.erase(v_type);
-    }
-}
+// 解シンク: 解 (頂点名の集合) が見つかるたびに呼ばれる
+// (並列探索時も呼び出しは直列化されるが、呼び出し順は探索順に依存する)
+using SolutionSink = std::function<void(const std::set<std::string>& solution)>;
 
 /**
- * @brief 制約付きグラフ列挙のメイン関数
+ * @brief 制約付きグラフ列挙のメイン関数 (ストリーミング版)
  * (BFS事前枝刈り＋詳細デバッグ出力)
+ * 解は保持せず、見つかるたびに sink へ渡します。
+ * sink は空でも構いません (options.path_observer_factory のオブザーバが解を受け取る場合など)。
+ * そのときは頂点名への変換を省き、解の数だけを数えます。
  */
-std::set<std::set<std::string>> findAllConstrainedGraphs(
-    tdzdd::Graph& graph, 
+inline void findAllConstrainedGraphs(
+    const GraphData& base_data, 
     const CoreGraph& core_graph, 
     const std::string& root_name,
-    std::ostream& log_stream // <-- 【追加】
+    std::ostream& log_stream,
+    const SolutionSink& sink,
+    const SearchOptions& options = SearchOptions(),
+    SearchStats* stats = nullptr
 ) {
-    std::set<std::set<std::string>> all_solutions; 
+    ScopedPhase pruning_phase(Phase::BfsPruning); // (手順 1-5 と対称性の準備)
 
     // 1. コアタイプ数 n を取得
     std::set<std::string> all_types;
@@ -217,116 +181,198 @@ std::set<std::set<std::string>> findAllConstrainedGraphs(
     if (all_types.empty()) {
          // 致命的な警告は cerr にも出す
          std::cerr << "Warning: No types found in core graph." << std::endl;
-         log_stream << "Warning: No types found in core graph." << std::endl;
-         return all_solutions;
+         GR_LOG(log_stream, LogLevel::Warning, LogSubsystem::Search, "Warning: No types found in core graph." << '\n');
+         return;
     }
     int num_types = all_types.size();
     int max_distance = num_types - 1; 
-    log_stream << "  Core types found (num_types=" << num_types << "). Max hop distance set to " << max_distance << "." << std::endl;
-
+    GR_LOG(log_stream, LogLevel::Info, LogSubsystem::Search,
+           "  Core types found (num_types=" << num_types << "). Max hop distance set to " << max_distance << "." << '\n');
 
-    // 2. G' (隣接リスト) を作成
-    log_stream << "  Building G' (filtered adjacency list)..." << std::endl;
-    std::map<std::string, std::set<std::string>> adj_list_G_prime = buildFilteredAdjacencyList(graph, root_name); 
 
-    if (adj_list_G_prime.count(root_name) == 0) {
+    // 2. G (CSR) と G' (頂点マスク) を作成
+    GR_LOG(log_stream, LogLevel::Info, LogSubsystem::Search, "  Building G' (filtered CSR graph)..." << '\n');
+    if (getBaseType(root_name).empty()) {
+        throw std::runtime_error("Root name is invalid (no type): " + root_name);
+    }
+    std::vector<std::string> type_names(all_types.begin(), all_types.end());
+    auto vertex_name = [&base_data](int v) { return baseVertexName(base_data, v); };
+    CsrGraph csr_G = buildCsrFromGraph(base_data, type_names);
+
+    int root_index = findBaseVertex(base_data, root_name);
+    VertexMask mask_G_prime;
+    if (root_index >= 0) {
+        mask_G_prime = buildFilteredVertexMask(base_data, root_index);
+    }
+    if (root_index < 0 || !hasMaskedNeighbor(csr_G, mask_G_prime, root_index)) {
          // 致命的な警告は cerr にも出す
          std::cerr << "Warning: Root vertex " << root_name << " is not in the filtered graph (or has no edges)." << std::endl;
-         log_stream << "Warning: Root vertex " << root_name << " is not in the filtered graph (or has no edges)." << std::endl;
-         return all_solutions;
+         GR_LOG(log_stream, LogLevel::Warning, LogSubsystem::Search,
+                "Warning: Root vertex " << root_name << " is not in the filtered graph (or has no edges)." << '\n');
+         return;
     }
 
     // 3. G' でBFSを実行し、ホップ数を計算
-    log_stream << "  Running BFS from " << root_name << " on G'..." << std::endl;
-    std::map<std::string, int> distances = calculateDistancesBFS(root_name, adj_list_G_prime); 
+    GR_LOG(log_stream, LogLevel::Info, LogSubsystem::Search, "  Running BFS from " << root_name << " on G'..." << '\n');
+    std::vector<int> distances, bfs_frontier, bfs_next_frontier;
+    bfsDistances(csr_G, mask_G_prime, root_index, distances, bfs_frontier, bfs_next_frontier);
 
     // 4. G'' (n-1 ホップ以内) を作成
-    log_stream << "  Building G'' (filtering by max distance)..." << std::endl;
-
-    // --- デバッグ: G' の全頂点セットを作成 ---
-    std::set<std::string> all_nodes_in_g_prime;
-    for(const auto& pair : adj_list_G_prime) {
-        all_nodes_in_g_prime.insert(pair.first);
-        for(const std::string& v : pair.second) {
-            all_nodes_in_g_prime.insert(v);
+    GR_LOG(log_stream, LogLevel::Info, LogSubsystem::Search, "  Building G'' (filtering by max distance)..." << '\n');
+    VertexMask mask_G_double_prime = filterMaskByDistance(mask_G_prime, distances, max_distance);
+
+    // --- デバッグ: G' / G'' の頂点 (辺を1本以上持つ頂点) を頂点名順に列挙 (Debug レベルのときだけ組み立てる) ---
+    if (GR_LOG_ENABLED(LogLevel::Debug, LogSubsystem::Search)) {
+        std::vector<std::pair<std::string, int>> nodes_in_g_prime;
+        int g_double_prime_total_nodes = 0;
+        for (int v = 0; v < csr_G.vertexSize(); ++v) {
+            if (hasMaskedNeighbor(csr_G, mask_G_prime, v)) nodes_in_g_prime.push_back({vertex_name(v), v});
+            if (hasMaskedNeighbor(csr_G, mask_G_double_prime, v)) g_double_prime_total_nodes++;
         }
-    }
-    int g_prime_total_nodes = all_nodes_in_g_prime.size();
-
-    // G'' を作成
-    std::map<std::string, std::set<std::string>> adj_list_G_double_prime = 
-        filterGraphByDistance(adj_list_G_prime, distances, max_distance); 
-
-    // --- デバッグ: G'' の全頂点セットを作成 ---
-    std::set<std::string> all_nodes_in_g_double_prime;
-    for(const auto& pair : adj_list_G_double_prime) {
-        all_nodes_in_g_double_prime.insert(pair.first);
-        for(const std::string& v : pair.second) {
-            all_nodes_in_g_double_prime.insert(v);
+        std::sort(nodes_in_g_prime.begin(), nodes_in_g_prime.end());
+        int g_prime_total_nodes = nodes_in_g_prime.size();
+
+        log_stream << "  [DEBUG] G' (original) total vertices: " << g_prime_total_nodes << '\n';
+        log_stream << "  [DEBUG] G' vertices list: (";
+        bool first_g_prime = true;
+        for (const auto& node : nodes_in_g_prime) {
+            if (!first_g_prime) {
+                log_stream << ", ";
+            }
+            log_stream << node.first;
+            first_g_prime = false;
         }
-    }
-    int g_double_prime_total_nodes = all_nodes_in_g_double_prime.size();
-
-    // --- デバッグ出力 (log_stream へ) ---
-    log_stream << "  [DEBUG] G' (original) total vertices: " << g_prime_total_nodes << std::endl;
-    log_stream << "  [DEBUG] G' vertices list: (";
-    bool first_g_prime = true;
-    for (const std::string& v : all_nodes_in_g_prime) {
-        if (!first_g_prime) {
-            log_stream << ", ";
+        if (first_g_prime) {
+            log_stream << "None";
         }
-        log_stream << v;
-        first_g_prime = false;
-    }
-    if (first_g_prime) {
-        log_stream << "None";
-    }
-    log_stream << ")" << std::endl;
+        log_stream << ")" << '\n';
 
-    log_stream << "  [DEBUG] G'' (pruned) total vertices: " << g_double_prime_total_nodes << std::endl;
-    log_stream << "  [DEBUG] Vertices pruned by BFS: " << (g_prime_total_nodes - g_double_prime_total_nodes) << std::endl;
+        log_stream << "  [DEBUG] G'' (pruned) total vertices: " << g_double_prime_total_nodes << '\n';
+        log_stream << "  [DEBUG] Vertices pruned by BFS: " << (g_prime_total_nodes - g_double_prime_total_nodes) << '\n';
 
-    log_stream << "  [DEBUG] Pruned vertices list: (";
-    bool first_pruned = true;
-    for (const std::string& v : all_nodes_in_g_prime) {
-        if (all_nodes_in_g_double_prime.count(v) == 0) {
-            if (!first_pruned) {
-                log_stream << ", ";
+        log_stream << "  [DEBUG] Pruned vertices list: (";
+        bool first_pruned = true;
+        for (const auto& node : nodes_in_g_prime) {
+            if (!hasMaskedNeighbor(csr_G, mask_G_double_prime, node.second)) {
+                if (!first_pruned) {
+                    log_stream << ", ";
+                }
+                log_stream << node.first;
+                first_pruned = false;
             }
-            log_stream << v; 
-            first_pruned = false;
         }
+        if (first_pruned) {
+            log_stream << "None";
+        }
+        log_stream << ")" << '\n';
     }
-    if (first_pruned) {
-        log_stream << "None";
-    }
-    log_stream << ")" << std::endl;
     // --- デバッグここまで ---
 
 
-    if (adj_list_G_double_prime.count(root_name) == 0) {
+    if (!hasMaskedNeighbor(csr_G, mask_G_double_prime, root_index)) {
          std::cerr << "Warning: Root vertex " << root_name << " was pruned by BFS (or has no edges in G'')." << std::endl;
-         log_stream << "Warning: Root vertex " << root_name << " was pruned by BFS (or has no edges in G'')." << std::endl;
-         return all_solutions;
+         GR_LOG(log_stream, LogLevel::Warning, LogSubsystem::Search,
+                "Warning: Root vertex " << root_name << " was pruned by BFS (or has no edges in G'')." << '\n');
+         return;
+    }
+
+    // 5. G'' を探索用の整数ID・ビットセット表現に詰め直す
+    IndexedSearchGraph search_graph = buildIndexedSearchGraph(csr_G, vertex_name, mask_G_double_prime, num_types);
+    int root_id = static_cast<int>(
+        std::lower_bound(search_graph.names.begin(), search_graph.names.end(), root_name) - search_graph.names.begin()
+    );
+
+    IndexedSearchState state = makeIndexedSearchState(search_graph, {root_id}, DynamicBitset(search_graph.names.size()));
+    int root_type = search_graph.graph.type_id[root_id];
+
+    DynamicBitset initial_frontier(search_graph.names.size());
+    for (int n : search_graph.graph.neighbors(root_id)) {
+        initial_frontier.set(n);
+    }
+    if (root_type >= 0) {
+        initial_frontier.andNot(search_graph.type_masks[root_type]);
     }
 
-    // 5. G'' を使ってバックトラッキング探索を開始
-    std::set<std::string> initial_path = {root_name};
-    std::set<std::string> types_collected = {getBaseType(root_name)};
-    std::set<std::string> initial_frontier_raw = adj_list_G_double_prime.at(root_name);
-    
-    std::set<std::string> initial_frontier;
-     for (const std::string& v_f : initial_frontier_raw) {
-        std::string f_type = getBaseType(v_f);
-        if (f_type.empty() || !types_collected.count(f_type)) {
-            initial_frontier.insert(v_f);
+    // (対称性枝刈り) ルートでは全ての対称性がパスと除外頂点を保つ
+    if (options.use_symmetry) {
+        computeSearchSymmetries(search_graph, root_id, options.symmetry_validator, log_stream);
+        for (size_t i = 0; i < search_graph.symmetries.size(); ++i) {
+            state.stabilizer.push_back(static_cast<int>(i));
         }
     }
 
-    log_stream << "  Starting recursive search on G''..." << std::endl;
-    findSolutionsRecursive(initial_path, types_collected, initial_frontier, 
-                           all_solutions, adj_list_G_double_prime, all_types); 
+    // (増分処理) ルートをパスに積んだ状態から通知を始める
+    std::unique_ptr<SearchPathObserver> root_observer;
+    if (options.path_observer_factory) {
+        root_observer = options.path_observer_factory(search_graph);
+        root_observer->pushVertex(root_id);
+        state.observer = root_observer.get();
+    }
+
+    pruning_phase.stop();
+
+    // 6. G'' を使ってバックトラッキング探索を開始 (各解はちょうど一度だけ生成される)
+    //    頂点名への変換は出力境界 (sink に渡す直前) でのみ行う
+    size_t num_solutions = 0;
+    IndexedSolutionSink indexed_sink = [&](const std::vector<int>& solution) {
+        num_solutions++;
+        if (sink) sink(indexedSolutionToNames(search_graph, solution));
+    };
+
+    if (options.num_threads > 1) {
+        GR_LOG(log_stream, LogLevel::Info, LogSubsystem::Search,
+               "  Starting parallel search on G'' (" << search_graph.names.size() << " indexed vertices, "
+               << options.num_threads << " threads, split depth " << options.split_depth << ")..." << '\n');
+        // (backtracking の時間は各ワーカーが計る: このスレッドの待ち時間を重ねて数えないように、ここでは計らない)
+        runParallelIndexedSearch(search_graph, state, initial_frontier,
+                                 options.num_threads, options.split_depth, indexed_sink, options.path_observer_factory);
+    } else {
+        GR_LOG(log_stream, LogLevel::Info, LogSubsystem::Search,
+               "  Starting recursive search on G'' (" << search_graph.names.size() << " indexed vertices)..." << '\n');
+        ScopedPhase search_phase(Phase::Backtracking);
+        findSolutionsIndexed(search_graph, state, initial_frontier, indexed_sink);
+    }
+    addCounter(Counter::SearchNodes, state.nodes_visited);
+    addCounter(Counter::SearchExpandedNodes, state.expanded_nodes);
+    addCounter(Counter::SearchFrontierTotal, state.frontier_total);
+    maxCounter(Counter::SearchFrontierMax, state.max_frontier);
+    addCounter(Counter::Solutions, static_cast<long long>(num_solutions));
+    if (GR_LOG_ENABLED(LogLevel::Info, LogSubsystem::Search)) {
+        log_stream << "  Search visited " << state.nodes_visited << " nodes and found "
+                   << num_solutions << (options.use_symmetry ? " symmetry-distinct representative solutions" : " solutions");
+        if (options.use_symmetry) {
+            log_stream << " (" << state.symmetry_pruned << " branches pruned by symmetry)";
+        }
+        log_stream << "." << '\n';
+    }
+    log_stream.flush(); // (探索の段階の区切り)
 
+    if (stats) {
+        stats->nodes_visited = state.nodes_visited;
+        stats->symmetry_pruned = state.symmetry_pruned;
+        stats->num_solutions = num_solutions;
+    }
+}
+
+/**
+ * @brief 制約付きグラフ列挙のメイン関数 (全解を返す版)
+ * 解はスレッド数によらず同じ順序 (std::set の辞書順) で返します。
+ */
+inline std::vector<std::set<std::string>> findAllConstrainedGraphs(
+    const GraphData& base_data, 
+    const CoreGraph& core_graph, 
+    const std::string& root_name,
+    std::ostream& log_stream, // <-- 【追加】
+    const SearchOptions& options = SearchOptions(),
+    SearchStats* stats = nullptr
+) {
+    std::vector<std::set<std::string>> all_solutions; 
+    findAllConstrainedGraphs(base_data, core_graph, root_name, log_stream,
+        [&all_solutions](const std::set<std::string>& solution) {
+            all_solutions.push_back(solution);
+        },
+        options, stats);
+    std::sort(all_solutions.begin(), all_solutions.end());
     return all_solutions;
 }
 
@@ -0,0 +1,73 @@
+#ifndef DYNAMIC_BITSET_HPP
+#define DYNAMIC_BITSET_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief 探索用の可変長ビットセット (64bit ワード配列)
+ * パス・フロンティア・収集済みタイプを整数IDの集合として保持するために使用します。
+ * 同じサイズ同士の演算のみを想定しています。
+ */
+class DynamicBitset {
+public:
+    DynamicBitset() : num_bits_(0) {}
+    explicit DynamicBitset(size_t num_bits)
+        : num_bits_(num_bits), words_((num_bits + 63) / 64, 0) {}
+
+    size_t size() const { return num_bits_; }
+
+    void set(size_t i) { words_[i >> 6] |= (uint64_t(1) << (i & 63)); }
+    void reset(size_t i) { words_[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+    bool test(size_t i) const { return (words_[i >> 6] >> (i & 63)) & 1; }
+
+    bool any() const {
+        for (uint64_t w : words_) {
+            if (w) return true;
+        }
+        return false;
+    }
+
+    size_t count() const {
+        size_t c = 0;
+        for (uint64_t w : words_) c += __builtin_popcountll(w);
+        return c;
+    }
+
+    // this |= other
+    DynamicBitset& operator|=(const DynamicBitset& other) {
+        for (size_t k = 0; k < words_.size(); ++k) words_[k] |= other.words_[k];
+        return *this;
+    }
+
+    // this &= ~other
+    DynamicBitset& andNot(const DynamicBitset& other) {
+        for (size_t k = 0; k < words_.size(); ++k) words_[k] &= ~other.words_[k];
+        return *this;
+    }
+
+    /**
+     * @brief 立っているビットを昇順に走査し、f(index) を呼び出します。
+     */
+    template <typename F>
+    void forEach(F&& f) const {
+        for (size_t k = 0; k < words_.size(); ++k) {
+            uint64_t w = words_[k];
+            while (w) {
+                int bit = __builtin_ctzll(w);
+                f(k * 64 + bit);
+                w &= w - 1;
+            }
+        }
+    }
+
+    bool operator==(const DynamicBitset& other) const { return words_ == other.words_; }
+    bool operator<(const DynamicBitset& other) const { return words_ < other.words_; }
+
+private:
+    size_t num_bits_;
+    std::vector<uint64_t> words_;
+};
+
+#endif // DYNAMIC_BITSET_HPP
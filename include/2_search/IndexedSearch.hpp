@@ -0,0 +1,306 @@
+#ifndef INDEXED_SEARCH_HPP
+#define INDEXED_SEARCH_HPP
+
+#include <set>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <algorithm>
+
+#include "1_core_graph/CsrGraph.hpp"
+#include "1_core_graph/Instrumentation.hpp"
+#include "2_search/DynamicBitset.hpp"
+
+/**
+ * @brief 整数IDで表現した探索用グラフ (G'')
+ * 頂点名は出力時の変換にだけ使い、探索中は整数IDとビットセットのみを扱います。
+ */
+struct IndexedSearchGraph {
+    std::vector<std::string> names;          // 頂点ID -> 頂点名 ("0_a" など)
+    CsrGraph graph;                          // 隣接構造 (CSR) と 頂点ID -> タイプID (タイプ不明は -1)
+    std::vector<DynamicBitset> type_masks;   // タイプID -> そのタイプに属する頂点のビットセット
+    int num_types = 0;
+    std::vector<std::vector<int>> symmetries; // 対称性枝刈りに使う自己同型 (恒等写像を除く頂点IDの置換)
+};
+
+/**
+ * @brief 探索パスの変化を受け取るオブザーバ (解ごとの後処理を探索木に沿って増分的に行うため)
+ * pushVertex / popVertex はパスへの頂点の追加・取り消し (後入れ先出し) のたびに、
+ * solutionFound は解 (頂点IDの昇順) が見つかるたびに、探索しているスレッドから呼ばれます。
+ * 並列探索ではワーカーごとに別のオブザーバを使います。
+ */
+class SearchPathObserver {
+public:
+    virtual ~SearchPathObserver() = default;
+    virtual void pushVertex(int vertex) = 0;
+    virtual void popVertex() = 0;
+    virtual void solutionFound(const std::vector<int>& solution) = 0;
+};
+
+// オブザーバの生成 (探索グラフが決まった後、探索状態ごとに呼ばれる)
+using SearchPathObserverFactory = std::function<std::unique_ptr<SearchPathObserver>(const IndexedSearchGraph& g)>;
+
+/**
+ * @brief 探索中に更新される状態 (パス・除外頂点・収集済みタイプ)
+ */
+struct IndexedSearchState {
+    DynamicBitset path;            // パスに含まれる頂点
+    std::vector<int> path_stack;   // パスに含まれる頂点 (追加順)
+    DynamicBitset excluded;        // この部分木では二度と追加しない頂点 (兄弟ノードで試行済み)
+    DynamicBitset types_collected; // 収集済みタイプ
+    int num_types_collected = 0;
+    std::vector<int> stabilizer;   // (パス, 除外頂点) を保つ自己同型の番号 (g.symmetries の添字)
+    long long nodes_visited = 0;   // 訪問した探索ノード数 (統計用)
+    long long symmetry_pruned = 0; // 対称性により枝刈りした子ノード数 (統計用)
+    long long expanded_nodes = 0;  // 子を展開したノード数 (計測用, GRADUATION_RESEARCH_INSTRUMENTATION のときだけ数える)
+    long long frontier_total = 0;  // 展開したノードのフロンティアの大きさの合計 (計測用)
+    long long max_frontier = 0;    // フロンティアの最大の大きさ (計測用)
+    SearchPathObserver* observer = nullptr; // パスの変化の通知先 (無ければ nullptr)
+};
+
+// (計測) 子を展開するノードのフロンティアの大きさを記録
+inline void recordFrontierSize(IndexedSearchState& state, const DynamicBitset& frontier) {
+#if GRADUATION_RESEARCH_INSTRUMENTATION
+    long long size = static_cast<long long>(frontier.count());
+    state.expanded_nodes++;
+    state.frontier_total += size;
+    if (size > state.max_frontier) state.max_frontier = size;
+#else
+    (void)state;
+    (void)frontier;
+#endif
+}
+
+// 統計用のカウンタを合算 (並列探索でワーカーの分をまとめる)
+inline void mergeSearchCounters(IndexedSearchState& into, const IndexedSearchState& from) {
+    into.nodes_visited += from.nodes_visited;
+    into.symmetry_pruned += from.symmetry_pruned;
+    into.expanded_nodes += from.expanded_nodes;
+    into.frontier_total += from.frontier_total;
+    into.max_frontier = std::max(into.max_frontier, from.max_frontier);
+}
+
+/**
+ * @brief 並列探索の分割点で切り出した部分木 (タスク)
+ * パス (追加順)・除外頂点・その時点のフロンティアだけで探索状態を復元できます。
+ */
+struct IndexedSearchTask {
+    std::vector<int> path_stack;
+    DynamicBitset excluded;
+    DynamicBitset frontier;
+    std::vector<int> stabilizer;
+};
+
+/**
+ * @brief path_stack と除外頂点 (と対称性の安定化部分群) から探索状態を復元します。
+ */
+inline IndexedSearchState makeIndexedSearchState(
+    const IndexedSearchGraph& g,
+    const std::vector<int>& path_stack,
+    const DynamicBitset& excluded,
+    const std::vector<int>& stabilizer = std::vector<int>()
+) {
+    IndexedSearchState state;
+    state.path = DynamicBitset(g.names.size());
+    state.excluded = excluded;
+    state.stabilizer = stabilizer;
+    state.types_collected = DynamicBitset(g.num_types);
+    for (int v : path_stack) {
+        state.path.set(v);
+        state.path_stack.push_back(v);
+        int t = g.graph.type_id[v];
+        if (t >= 0 && !state.types_collected.test(t)) {
+            state.types_collected.set(t);
+            state.num_types_collected++;
+        }
+    }
+    return state;
+}
+
+/**
+ * @brief 現在の状態から1頂点を追加した子ノードを順に訪問します。
+ * 子ごとに (A) 選択 → (B) フロンティア更新 → visit_child(new_frontier) → (C) バックトラック を行います。
+ *
+ * 正規拡張規則 (ESU 方式): フロンティアの頂点 v_1 < v_2 < ... を順に試し、
+ * v_i を追加する子の部分木では v_1 ... v_{i-1} を「除外頂点」として二度と追加しません。
+ * これにより、ルートを含む連結な頂点集合はそれぞれ探索木のちょうど1つの葉にだけ現れ、
+ * 異なる追加順で同じ部分木を繰り返し探索することがなくなります。
+ *
+ * 対称性枝刈り (軌道枝刈り): (パス, 除外頂点) を保つ自己同型 σ が v_i を先に試した v_j (j < i) に移すなら、
+ * v_i の部分木の解 S の像 σ(S) は v_j 以前の部分木に必ず含まれるため、v_i の子は訪問しません。
+ * (各対称類の少なくとも1つの解は必ず残ります)
+ */
+template <typename Visitor>
+inline void forEachIndexedChild(
+    const IndexedSearchGraph& g,
+    IndexedSearchState& state,
+    const DynamicBitset& frontier,
+    Visitor&& visit_child
+) {
+    std::vector<int> newly_excluded;
+
+    // フロンティアの頂点を ID 昇順に試す
+    frontier.forEach([&](size_t next_vertex) {
+        int v_type = g.graph.type_id[next_vertex];
+
+        // タイプ不明 / 収集済みのタイプは無視
+        if (v_type < 0 || state.types_collected.test(v_type)) {
+            return;
+        }
+
+        // 対称性: 先に試した兄弟に移る自己同型があれば枝刈り
+        // (σ は フロンティア を保つので、像が除外頂点にあれば この階層で試行済み)
+        std::vector<int> child_stabilizer;
+        bool pruned = false;
+        for (int sigma : state.stabilizer) {
+            const std::vector<int>& perm = g.symmetries[sigma];
+            int image = perm[next_vertex];
+            if (image != static_cast<int>(next_vertex) && state.excluded.test(image)) {
+                pruned = true;
+                break;
+            }
+            // 子ノードの安定化部分群: next_vertex を固定し、この階層の試行済み頂点集合を保つもの
+            if (image != static_cast<int>(next_vertex)) continue;
+            bool keeps_tried = true;
+            for (int t : newly_excluded) {
+                if (!state.excluded.test(perm[t])) {
+                    keeps_tried = false;
+                    break;
+                }
+            }
+            if (keeps_tried) child_stabilizer.push_back(sigma);
+        }
+        if (pruned) {
+            state.symmetry_pruned++;
+            state.excluded.set(next_vertex);
+            newly_excluded.push_back(static_cast<int>(next_vertex));
+            return;
+        }
+
+        // (A) 選択
+        state.path.set(next_vertex);
+        state.path_stack.push_back(static_cast<int>(next_vertex));
+        state.types_collected.set(v_type);
+        state.num_types_collected++;
+        if (state.observer) state.observer->pushVertex(static_cast<int>(next_vertex));
+
+        // (B) 新しいフロンティア = (フロンティア ∪ 隣接) - パス - 除外頂点 - 収集済みタイプ
+        DynamicBitset new_frontier = frontier;
+        for (int n : g.graph.neighbors(static_cast<int>(next_vertex))) {
+            new_frontier.set(n);
+        }
+        new_frontier.andNot(state.path);
+        new_frontier.andNot(state.excluded);
+        new_frontier.andNot(g.type_masks[v_type]);
+
+        state.stabilizer.swap(child_stabilizer);
+        visit_child(new_frontier);
+        state.stabilizer.swap(child_stabilizer);
+
+        // (C) バックトラック
+        if (state.observer) state.observer->popVertex();
+        state.num_types_collected--;
+        state.types_collected.reset(v_type);
+        state.path_stack.pop_back();
+        state.path.reset(next_vertex);
+
+        // 以降の兄弟ノードでは next_vertex を除外
+        state.excluded.set(next_vertex);
+        newly_excluded.push_back(static_cast<int>(next_vertex));
+    });
+
+    // この階層で追加した除外頂点を元に戻す
+    for (int v : newly_excluded) {
+        state.excluded.reset(v);
+    }
+}
+
+// ヘルパー: 現在のパスを解 (頂点ID昇順) に変換 (オブザーバがあれば解を通知)
+inline std::vector<int> currentIndexedSolution(const IndexedSearchState& state) {
+    std::vector<int> solution = state.path_stack;
+    std::sort(solution.begin(), solution.end());
+    if (state.observer) state.observer->solutionFound(solution);
+    return solution;
+}
+
+/**
+ * @brief 整数ID・ビットセット版の再帰バックトラッキング
+ * 正規拡張規則により各解は一度だけ生成されます。
+ * 解が見つかるたびに emit(solution) が呼ばれます (solution は頂点IDの昇順ベクタ)。
+ */
+template <typename Emit>
+inline void findSolutionsIndexed(
+    const IndexedSearchGraph& g,
+    IndexedSearchState& state,
+    const DynamicBitset& frontier,
+    Emit&& emit
+) {
+    state.nodes_visited++;
+
+    // 1. 成功のベースケース
+    if (state.num_types_collected == g.num_types) {
+        emit(currentIndexedSolution(state));
+        return;
+    }
+
+    // 2. 失敗のベースケース
+    if (!frontier.any()) {
+        return;
+    }
+
+    // 3. 再帰ステップ
+    recordFrontierSize(state, frontier);
+    forEachIndexedChild(g, state, frontier, [&](const DynamicBitset& new_frontier) {
+        findSolutionsIndexed(g, state, new_frontier, emit);
+    });
+}
+
+/**
+ * @brief 探索木を split_depth 段目 (ルートからの追加頂点数) まで展開し、タスクに分割します。
+ * split_depth より浅い位置で見つかった解は emit に直接渡します。
+ */
+template <typename Emit>
+inline void splitIndexedSearchTree(
+    const IndexedSearchGraph& g,
+    IndexedSearchState& state,
+    const DynamicBitset& frontier,
+    int depth,
+    int split_depth,
+    std::vector<IndexedSearchTask>& tasks,
+    Emit&& emit
+) {
+    if (depth >= split_depth && state.num_types_collected < g.num_types && frontier.any()) {
+        tasks.push_back({state.path_stack, state.excluded, frontier, state.stabilizer});
+        return;
+    }
+    state.nodes_visited++;
+    if (state.num_types_collected == g.num_types) {
+        emit(currentIndexedSolution(state));
+        return;
+    }
+    if (!frontier.any()) {
+        return;
+    }
+    recordFrontierSize(state, frontier);
+    forEachIndexedChild(g, state, frontier, [&](const DynamicBitset& new_frontier) {
+        splitIndexedSearchTree(g, state, new_frontier, depth + 1, split_depth, tasks, emit);
+    });
+}
+
+/**
+ * @brief 頂点IDの解を頂点名の集合に変換します (出力境界でのみ使用)
+ */
+inline std::set<std::string> indexedSolutionToNames(
+    const IndexedSearchGraph& g,
+    const std::vector<int>& solution
+) {
+    std::set<std::string> names;
+    for (int v : solution) {
+        names.insert(g.names[v]);
+    }
+    return names;
+}
+
+#endif // INDEXED_SEARCH_HPP
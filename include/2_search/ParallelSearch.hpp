@@ -0,0 +1,98 @@
+#ifndef PARALLEL_SEARCH_HPP
+#define PARALLEL_SEARCH_HPP
+
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <functional>
+
+#include "2_search/IndexedSearch.hpp"
+#include "2_search/WorkStealingPool.hpp"
+
+// 解シンク (頂点ID版): 解が見つかるたびに呼ばれる
+using IndexedSolutionSink = std::function<void(const std::vector<int>& solution)>;
+
+/**
+ * @brief 探索木を split_depth 段目で分割し、ワークスティーリング・プールで並列に探索します。
+ * 各ワーカーは自分専用のバッファに解を溜め、一定数ごとにまとめて sink へ流します。
+ * (ワーカー同士が共有の解集合を奪い合うことはなく、sink の呼び出しは常に1スレッドずつに直列化されます)
+ * 正規拡張規則によりタスク間で解が重複することはありません。
+ * sink の呼び出し順はスレッドのスケジュールに依存するため、決定的な結果が必要な場合は受け手側で順序付けしてください。
+ * 全ワーカーの訪問ノード数・対称性枝刈り数などの統計は root_state に合算して返します。
+ * observer_factory があれば、ワーカーごとにオブザーバを1つ作り、タスクの開始時にそのパスを通知し直します。
+ * backtracking の時間は、タスクを作る浅い探索とワーカーの探索の分だけを各スレッドで計ります
+ * (呼び出し元スレッドがプールの終了を待つ時間は含めません。sink の中の段階は入れ子として差し引かれます)。
+ */
+inline void runParallelIndexedSearch(
+    const IndexedSearchGraph& g,
+    IndexedSearchState& root_state,
+    const DynamicBitset& root_frontier,
+    int num_threads,
+    int split_depth,
+    const IndexedSolutionSink& sink,
+    const SearchPathObserverFactory& observer_factory = nullptr
+) {
+    const size_t kFlushBatchSize = 256;
+    std::mutex sink_mutex;
+
+    // 1. 探索木の浅い部分を展開してタスクを作成 (ここで見つかった解はそのまま sink へ)
+    std::vector<IndexedSearchTask> tasks;
+    {
+        ScopedPhase split_phase(Phase::Backtracking);
+        splitIndexedSearchTree(g, root_state, root_frontier, 0, split_depth, tasks, sink);
+    }
+
+    // 2. ワーカーごとの解バッファ
+    WorkStealingPool pool(num_threads);
+    std::vector<std::vector<std::vector<int>>> local_solutions(pool.numThreads());
+    std::vector<IndexedSearchState> local_counters(pool.numThreads()); // (統計用のカウンタだけを使う)
+    std::vector<std::unique_ptr<SearchPathObserver>> local_observers(pool.numThreads());
+
+    auto flush = [&](std::vector<std::vector<int>>& buffer) {
+        std::lock_guard<std::mutex> lock(sink_mutex);
+        for (const std::vector<int>& solution : buffer) {
+            sink(solution);
+        }
+        buffer.clear();
+    };
+
+    std::vector<WorkStealingPool::Task> jobs;
+    jobs.reserve(tasks.size());
+    for (const IndexedSearchTask& task : tasks) {
+        jobs.push_back([&g, &task, &local_solutions, &local_counters, &local_observers,
+                        &observer_factory, &flush, kFlushBatchSize](int worker_id) {
+            std::vector<std::vector<int>>& buffer = local_solutions[worker_id];
+            IndexedSearchState state = makeIndexedSearchState(g, task.path_stack, task.excluded, task.stabilizer);
+            if (observer_factory) {
+                if (!local_observers[worker_id]) local_observers[worker_id] = observer_factory(g);
+                state.observer = local_observers[worker_id].get();
+                for (int v : task.path_stack) state.observer->pushVertex(v);
+            }
+            try {
+                ScopedPhase search_phase(Phase::Backtracking); // (flush の中の sink の段階は入れ子で止まる)
+                findSolutionsIndexed(g, state, task.frontier, [&](std::vector<int>&& solution) {
+                    buffer.push_back(std::move(solution));
+                    if (buffer.size() >= kFlushBatchSize) {
+                        flush(buffer);
+                    }
+                });
+            } catch (...) {
+                local_observers[worker_id].reset(); // パスの通知が途中で切れたオブザーバは使い回さない
+                throw;
+            }
+            if (state.observer) {
+                for (size_t i = 0; i < task.path_stack.size(); ++i) state.observer->popVertex();
+            }
+            mergeSearchCounters(local_counters[worker_id], state);
+        });
+    }
+
+    // 3. 実行と残りのバッファの排出
+    pool.run(std::move(jobs));
+    for (int w = 0; w < pool.numThreads(); ++w) {
+        flush(local_solutions[w]);
+        mergeSearchCounters(root_state, local_counters[w]);
+    }
+}
+
+#endif // PARALLEL_SEARCH_HPP
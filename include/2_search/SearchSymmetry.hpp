@@ -0,0 +1,192 @@
+#ifndef SEARCH_SYMMETRY_HPP
+#define SEARCH_SYMMETRY_HPP
+
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <ostream>
+#include <mutex>
+
+#include "1_core_graph/Instrumentation.hpp"
+#include "1_core_graph/Logging.hpp"
+#include "1_core_graph/NautyLock.hpp"
+#include "2_search/IndexedSearch.hpp"
+
+// C++コードから C言語の nauty ヘッダをインクルードする
+extern "C" {
+    #include "nauty.h"
+    #include "nausparse.h"
+}
+
+// コアIDの対応 (元のコアID -> 移り先のコアID) が幾何的に正当な対称性かを判定するコールバック
+using CoreMapValidator = std::function<bool(const std::map<int, int>& core_map)>;
+
+// nauty の userautomproc は C の関数ポインタなので、生成元は静的領域に集める
+// (nautyMutex() を持っている間だけ触る: USE_TLS でもこの領域はスレッド間で共有される)
+inline std::vector<std::vector<int>>& collectedAutomorphisms() {
+    static std::vector<std::vector<int>> generators;
+    return generators;
+}
+
+inline void collectAutomorphism(int count, int* perm, int* orbits, int numorbits, int stabvertex, int n) {
+    (void)count; (void)orbits; (void)numorbits; (void)stabvertex;
+    collectedAutomorphisms().push_back(std::vector<int>(perm, perm + n));
+}
+
+// ヘルパー: 頂点名 (例: "12_b") からコアID (12) を抽出 (失敗時は -1)
+inline int parseCoreId(const std::string& full_name) {
+    size_t underscore = full_name.find('_');
+    if (underscore == std::string::npos || underscore == 0) return -1;
+    int core_id = 0;
+    for (size_t i = 0; i < underscore; ++i) {
+        char ch = full_name[i];
+        if (ch < '0' || ch > '9') return -1;
+        core_id = core_id * 10 + (ch - '0');
+    }
+    return core_id;
+}
+
+/**
+ * @brief 頂点の置換が「コア単位の置換」になっているか確かめ、コアIDの対応を取り出します。
+ * (同じコアに属する頂点がすべて同じコアに移る場合のみ true)
+ */
+inline bool extractCoreMap(
+    const IndexedSearchGraph& g,
+    const std::vector<int>& perm,
+    std::map<int, int>& core_map
+) {
+    core_map.clear();
+    for (size_t v = 0; v < perm.size(); ++v) {
+        int from = parseCoreId(g.names[v]);
+        int to = parseCoreId(g.names[perm[v]]);
+        if (from < 0 || to < 0) return false;
+        auto it = core_map.find(from);
+        if (it == core_map.end()) {
+            core_map[from] = to;
+        } else if (it->second != to) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 探索グラフ G'' の対称性 (ルートを固定し、タイプを保つ自己同型) を求めて g.symmetries に格納します。
+ *
+ * 1. nauty (sparsenauty) に「ルート / タイプごと」の頂点彩色を与えて自己同型群の生成元を得る
+ * 2. validator で幾何的に正当と確認できた生成元だけを残す
+ * 3. 残った生成元から群を生成する (max_group_size を超えたら対称性枝刈りを諦める)
+ *
+ * 格子の平行移動による重複は、ルートを 0_a に固定した時点で既に除かれているため、
+ * ここで扱うのはルートを固定する回転・鏡映などの対称性です。
+ * 戻り値は恒等写像を除いた群の要素数です。
+ */
+inline size_t computeSearchSymmetries(
+    IndexedSearchGraph& g,
+    int root_id,
+    const CoreMapValidator& validator,
+    std::ostream& log_stream,
+    size_t max_group_size = 4096
+) {
+    g.symmetries.clear();
+    int n = static_cast<int>(g.names.size());
+    if (n == 0) return 0;
+
+    // 1. nauty 用の疎グラフを構築
+    size_t num_directed_edges = g.graph.adjacency.size();
+
+    sparsegraph sg;
+    SG_INIT(sg);
+    SG_ALLOC(sg, n, num_directed_edges, "malloc");
+    sg.nv = n;
+    sg.nde = num_directed_edges;
+    size_t k = 0;
+    for (int v = 0; v < n; ++v) {
+        // (CSR の隣接頂点は昇順に並んでいる)
+        sg.v[v] = k;
+        sg.d[v] = g.graph.degree(v);
+        for (int u : g.graph.neighbors(v)) sg.e[k++] = u;
+    }
+
+    // 2. 頂点彩色: [ルート] [タイプ0] [タイプ1] ... [タイプ不明]
+    std::vector<int> lab, ptn, orbits(n);
+    std::vector<std::vector<int>> cells(1 + g.num_types + 1);
+    cells[0].push_back(root_id);
+    for (int v = 0; v < n; ++v) {
+        if (v == root_id) continue;
+        int t = g.graph.type_id[v];
+        cells[t >= 0 ? 1 + t : 1 + g.num_types].push_back(v);
+    }
+    for (const auto& cell : cells) {
+        for (size_t i = 0; i < cell.size(); ++i) {
+            lab.push_back(cell[i]);
+            ptn.push_back(i + 1 < cell.size() ? 1 : 0);
+        }
+    }
+
+    DEFAULTOPTIONS_SPARSEGRAPH(options);
+    options.getcanon = FALSE;
+    options.defaultptn = FALSE;
+    options.userautomproc = collectAutomorphism;
+    statsblk stats;
+
+    std::vector<std::vector<int>> generators;
+    {
+        // (生成元の収集領域は共有なので、USE_TLS でも nauty の呼び出しから取り出しまでロックする)
+        std::lock_guard<std::mutex> lock(nautyMutex());
+        collectedAutomorphisms().clear();
+        {
+            ScopedPhase phase(Phase::Nauty); // (ロック待ちは含めない)
+            sparsenauty(&sg, lab.data(), ptn.data(), orbits.data(), &options, &stats, NULL);
+            addCounter(Counter::NautyCalls, 1);
+        }
+        generators.swap(collectedAutomorphisms());
+    }
+    SG_FREE(sg);
+
+    // 3. 幾何的に正当な生成元だけを残す
+    std::vector<std::vector<int>> valid_generators;
+    for (const auto& perm : generators) {
+        std::map<int, int> core_map;
+        if (extractCoreMap(g, perm, core_map) && validator && validator(core_map)) {
+            valid_generators.push_back(perm);
+        }
+    }
+    GR_LOG(log_stream, LogLevel::Info, LogSubsystem::Symmetry,
+           "  Symmetry: nauty found " << generators.size() << " generators, "
+           << valid_generators.size() << " of them are lattice isometries." << '\n');
+    if (valid_generators.empty()) return 0;
+
+    // 4. 生成元から群の要素を列挙 (幅優先で閉包を取る)
+    std::vector<int> identity(n);
+    for (int v = 0; v < n; ++v) identity[v] = v;
+    std::set<std::vector<int>> group = {identity};
+    std::vector<std::vector<int>> queue = {identity};
+    for (size_t head = 0; head < queue.size(); ++head) {
+        for (const auto& gen : valid_generators) {
+            std::vector<int> product(n);
+            for (int v = 0; v < n; ++v) product[v] = gen[queue[head][v]];
+            if (group.insert(product).second) {
+                if (group.size() > max_group_size) {
+                    GR_LOG(log_stream, LogLevel::Warning, LogSubsystem::Symmetry,
+                           "  Symmetry: group larger than " << max_group_size
+                           << " elements, symmetry pruning disabled." << '\n');
+                    return 0;
+                }
+                queue.push_back(product);
+            }
+        }
+    }
+
+    for (const auto& perm : group) {
+        if (perm != identity) g.symmetries.push_back(perm);
+    }
+    GR_LOG(log_stream, LogLevel::Info, LogSubsystem::Symmetry,
+           "  Symmetry: using a group of " << group.size() << " elements for orbit pruning." << '\n');
+    return g.symmetries.size();
+}
+
+#endif // SEARCH_SYMMETRY_HPP
@@ -0,0 +1,103 @@
+#ifndef WORK_STEALING_POOL_HPP
+#define WORK_STEALING_POOL_HPP
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <exception>
+#include <memory>
+
+/**
+ * @brief 固定タスク集合を複数スレッドで処理するワークスティーリング・スレッドプール
+ * タスクは各ワーカーの両端キューにラウンドロビンで配られ、
+ * ワーカーは自分のキューの末尾から取り出し、空になったら他ワーカーのキューの先頭から盗みます。
+ * タスクは実行中のワーカーID (0 ~ num_threads-1) を受け取るため、
+ * スレッドローカルなバッファをワーカーIDで引くことができます。
+ */
+class WorkStealingPool {
+public:
+    using Task = std::function<void(int worker_id)>;
+
+    explicit WorkStealingPool(int num_threads)
+        : num_threads_(num_threads < 1 ? 1 : num_threads) {}
+
+    int numThreads() const { return num_threads_; }
+
+    /**
+     * @brief 全タスクを実行し、すべて完了するまでブロックします。
+     * タスク内で送出された例外は、全スレッドの終了後に最初の1つを再送出します。
+     */
+    void run(std::vector<Task> tasks) {
+        std::vector<std::unique_ptr<WorkerQueue>> queues;
+        for (int i = 0; i < num_threads_; ++i) {
+            queues.emplace_back(new WorkerQueue());
+        }
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            queues[i % num_threads_]->tasks.push_back(std::move(tasks[i]));
+        }
+
+        std::mutex error_mutex;
+        std::exception_ptr first_error;
+
+        auto worker_loop = [&](int worker_id) {
+            Task task;
+            while (popOrSteal(queues, worker_id, task)) {
+                try {
+                    task(worker_id);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!first_error) first_error = std::current_exception();
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (int i = 1; i < num_threads_; ++i) {
+            threads.emplace_back(worker_loop, i);
+        }
+        worker_loop(0); // 呼び出し元スレッドもワーカー 0 として参加
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        if (first_error) {
+            std::rethrow_exception(first_error);
+        }
+    }
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    // 自分のキューの末尾 -> 他ワーカーのキューの先頭 の順にタスクを探す
+    // (タスクは実行中に増えないため、全キューが空なら終了してよい)
+    bool popOrSteal(std::vector<std::unique_ptr<WorkerQueue>>& queues, int worker_id, Task& out) {
+        {
+            WorkerQueue& own = *queues[worker_id];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                out = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (int k = 1; k < num_threads_; ++k) {
+            WorkerQueue& victim = *queues[(worker_id + k) % num_threads_];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                out = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int num_threads_;
+};
+
+#endif // WORK_STEALING_POOL_HPP
@@ -0,0 +1,83 @@
+#ifndef COINCIDENT_FACES_HPP
+#define COINCIDENT_FACES_HPP
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "1_core_graph/GridHashMap.hpp"   // mixHash64
+#include "1_core_graph/MakeBaseGraph.hpp" // GridPoint3D, GridPointHasher
+#include "3_geometry/ObjTypes.hpp"
+
+/**
+ * @brief 接合面 (量子化した頂点の集合が一致する面が2枚以上あるもの) に削除の印を付けます。
+ *
+ * 面ごとに量子化座標を並べ替えて重複を除いた小さな配列をキーとし、開番地法 (線形探査) の表で照合します。
+ * キーはすべて1本の平坦な配列に詰めるため、面ごとのメモリ確保はありません。
+ * grid_vertices は mesh の各頂点の量子化座標です。
+ * to_delete は面の数の大きさに作り直され、削除する面に true が入ります。戻り値は削除する面の数です。
+ */
+inline int markCoincidentFaces(
+    const PackedMesh& mesh,
+    const std::vector<GridPoint3D>& grid_vertices,
+    std::vector<bool>& to_delete
+) {
+    const int num_faces = mesh.faceSize();
+    to_delete.assign(num_faces, false);
+
+    // 1. 面ごとのキー (並べ替えて重複を除いた量子化座標) とそのハッシュ
+    std::vector<GridPoint3D> key_points;
+    key_points.reserve(mesh.face_indices.size());
+    std::vector<int> key_offsets;
+    key_offsets.reserve(num_faces + 1);
+    key_offsets.push_back(0);
+    std::vector<uint64_t> key_hashes(num_faces);
+    for (int f = 0; f < num_faces; ++f) {
+        const size_t first = key_points.size();
+        for (int idx : mesh.face(f)) key_points.push_back(grid_vertices[idx]);
+        std::sort(key_points.begin() + first, key_points.end());
+        key_points.erase(std::unique(key_points.begin() + first, key_points.end()), key_points.end());
+        key_offsets.push_back(static_cast<int>(key_points.size()));
+
+        uint64_t h = mixHash64(static_cast<uint64_t>(key_points.size() - first));
+        for (auto it = key_points.begin() + first; it != key_points.end(); ++it) {
+            h = mixHash64(h ^ GridPointHasher()(*it));
+        }
+        key_hashes[f] = h;
+    }
+    auto sameKey = [&](int a, int b) {
+        int size_a = key_offsets[a + 1] - key_offsets[a];
+        if (size_a != key_offsets[b + 1] - key_offsets[b]) return false;
+        return std::equal(key_points.begin() + key_offsets[a], key_points.begin() + key_offsets[a + 1],
+                          key_points.begin() + key_offsets[b]);
+    };
+
+    // 2. 表で同じキーの最初の面を引き、キーごとの面の数を数える
+    size_t capacity = 16;
+    while (capacity < static_cast<size_t>(num_faces) * 2) capacity <<= 1;
+    const size_t mask = capacity - 1;
+    std::vector<int> slots(capacity, -1);      // 面番号 (空きは -1)
+    std::vector<int> first_face(num_faces);    // 面 -> 同じキーを持つ最初の面
+    std::vector<int> key_count(num_faces, 0);  // 最初の面 -> そのキーを持つ面の数
+    for (int f = 0; f < num_faces; ++f) {
+        size_t i = key_hashes[f] & mask;
+        while (slots[i] >= 0 && !(key_hashes[slots[i]] == key_hashes[f] && sameKey(slots[i], f))) {
+            i = (i + 1) & mask;
+        }
+        if (slots[i] < 0) slots[i] = f;
+        first_face[f] = slots[i];
+        key_count[slots[i]]++;
+    }
+
+    // 3. 2枚以上が共有するキーの面すべてに印を付ける
+    int num_deleted = 0;
+    for (int f = 0; f < num_faces; ++f) {
+        if (key_count[first_face[f]] > 1) {
+            to_delete[f] = true;
+            num_deleted++;
+        }
+    }
+    return num_deleted;
+}
+
+#endif // COINCIDENT_FACES_HPP
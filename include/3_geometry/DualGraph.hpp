@@ -1,72 +1,90 @@
 #ifndef DUAL_GRAPH_HPP
 #define DUAL_GRAPH_HPP
 
-#include <map>
-#include <set>
-#include <string>
 #include <vector>
+#include <cstdint>
 #include <algorithm> // std::min, std::max
 
 #include "3_geometry/ObjTypes.hpp"
-#include "tdzdd/util/Graph.hpp" 
+#include "1_core_graph/IntGraph.hpp"
+#include "1_core_graph/Instrumentation.hpp"
+#include "1_core_graph/GridHashMap.hpp"
 #include "1_core_graph/MakeBaseGraph.hpp" // <-- 【追加】 GridPoint3D, quantize() のため
 
 /**
- * @brief ObjMesh から双対グラフ (Dual Graph) を構築します。
- * (修正: 頂点インデックスではなく、量子化された座標で辺を判定)
+ * @brief 双対グラフ構築の統計
  */
-inline tdzdd::Graph buildDualGraph(const ObjMesh& mesh) {
-    
-    tdzdd::Graph dual_graph;
-    
-    // --- ▼ 修正点: キーを <int, int> から <GridPoint3D, GridPoint3D> に変更 ▼ ---
-    // 量子化された辺 (v1, v2) -> この辺を共有する面のインデックス (のリスト)
-    std::map<std::pair<GridPoint3D, GridPoint3D>, std::vector<int>> edge_to_faces_map;
-    // --- ▲ 修正点 ▲ ---
-
-    // 1. 辺 -> 面 のマップを構築
-    for (int i = 0; i < mesh.faces.size(); ++i) {
-        const auto& face = mesh.faces[i]; 
-        
-        for (size_t j = 0; j < face.size(); ++j) {
-            int v1_idx = face[j];
-            int v2_idx = face[(j + 1) % face.size()]; 
+struct DualGraphStats {
+    long long boundary_edges = 0;     // 1つの面にしか属さない辺 (双対グラフの辺にならない)
+    long long non_manifold_edges = 0; // 3つ以上の面が共有する辺 (双対グラフの辺にせず、数だけ数える)
+};
 
-            // --- ▼ 修正点: 頂点インデックス -> 量子化座標 に変更 ▼ ---
-            
-            // 頂点座標を取得
-            const Point3D& p1 = mesh.vertices.at(v1_idx);
-            const Point3D& p2 = mesh.vertices.at(v2_idx);
+/**
+ * @brief メッシュから双対グラフ (Dual Graph) を構築します。
+ * 辺は頂点インデックスではなく、量子化された座標で判定します (溶接済みのメッシュでは頂点ID をそのまま使う)。
+ * 量子化座標に通し番号を振り、辺を (小さい番号, 大きい番号) を詰めた 64bit キーで開番地法の表に登録するため、
+ * 期待値で線形時間です。ちょうど2つの面が共有する辺ごとに、その2面を結ぶ辺を双対グラフに加えます。
+ * 双対グラフの頂点ID は面のインデックスです (面番号を文字列にはしません)。
+ */
+inline IntGraph buildDualGraph(const PackedMesh& mesh, DualGraphStats* stats = nullptr) {
+    ScopedPhase phase(Phase::DualBuild);
 
-            // 座標を量子化 (TOLERANCE = 0.1)
-            GridPoint3D g1 = quantize(p1);
-            GridPoint3D g2 = quantize(p2);
+    // 1. 頂点 -> 位置の番号 (量子化座標が同じ頂点は同じ番号)
+    std::vector<int> position_id(mesh.vertexSize());
+    if (mesh.welded) {
+        for (int v = 0; v < mesh.vertexSize(); ++v) position_id[v] = v;
+    } else {
+        OpenAddressingMap<GridPoint3D, int, GridPointHasher> position_to_id(mesh.vertexSize());
+        for (int v = 0; v < mesh.vertexSize(); ++v) {
+            int next_id = static_cast<int>(position_to_id.size());
+            position_id[v] = position_to_id.tryEmplace(quantize(mesh.vertex(v)), next_id).first;
+        }
+    }
 
-            // 辺を正規化 (GridPoint3D は MakeBaseGraph.hpp で operator< が定義済み)
-            std::pair<GridPoint3D, GridPoint3D> edge_key = {std::min(g1, g2), std::max(g1, g2)};
-            
-            // --- ▲ 修正点 ▲ ---
+    // 2. 辺 -> この辺を共有する面 (最初の2つと、共有する面の数)
+    struct EdgeFaces {
+        int first_face;
+        int second_face;
+        int count;
+    };
+    std::vector<EdgeFaces> edge_faces;
+    edge_faces.reserve(mesh.face_indices.size());
+    OpenAddressingMap<uint64_t, int, UInt64Hasher> edge_to_index(mesh.face_indices.size());
+    for (int i = 0; i < mesh.faceSize(); ++i) {
+        FaceRange face = mesh.face(i);
+        for (int j = 0; j < face.size(); ++j) {
+            int p1 = position_id[face[j]];
+            int p2 = position_id[face[(j + 1) % face.size()]];
+            uint64_t edge_key = (static_cast<uint64_t>(std::min(p1, p2)) << 32) | static_cast<uint32_t>(std::max(p1, p2));
 
-            // この辺(edge_key)は、面(i)に属している
-            edge_to_faces_map[edge_key].push_back(i);
+            auto found = edge_to_index.tryEmplace(edge_key, static_cast<int>(edge_faces.size()));
+            if (found.second) {
+                edge_faces.push_back({i, -1, 1});
+                continue;
+            }
+            EdgeFaces& edge = edge_faces[found.first];
+            if (edge.count == 1) edge.second_face = i;
+            edge.count++;
         }
     }
 
-    // 2. 双対グラフのエッジを構築
-    for (const auto& pair : edge_to_faces_map) {
-        const auto& faces_sharing_this_edge = pair.second;
-        
-        // 1つの辺(量子化済み)を2つの面が共有している場合
-        if (faces_sharing_this_edge.size() == 2) {
-            int face_idx_1 = faces_sharing_this_edge[0];
-            int face_idx_2 = faces_sharing_this_edge[1];
-            
-            dual_graph.addEdge(std::to_string(face_idx_1), std::to_string(face_idx_2));
+    // 3. 双対グラフのエッジを構築 (1つの辺を2つの面が共有している場合)
+    std::vector<std::pair<int, int>> dual_edges;
+    for (const EdgeFaces& edge : edge_faces) {
+        if (edge.count == 2) {
+            dual_edges.push_back({edge.first_face, edge.second_face});
+        } else if (stats) {
+            if (edge.count == 1) stats->boundary_edges++;
+            else stats->non_manifold_edges++;
         }
     }
     
-    dual_graph.update();
-    return dual_graph;
+    return buildIntGraph(mesh.faceSize(), dual_edges);
+}
+
+// アダプタ: ローダー形式の ObjMesh から構築
+inline IntGraph buildDualGraph(const ObjMesh& mesh, DualGraphStats* stats = nullptr) {
+    return buildDualGraph(packMesh(mesh), stats);
 }
 
-#endif // DUAL_GRAPH_HPP
\ No newline at end of file
+#endif // DUAL_GRAPH_HPP
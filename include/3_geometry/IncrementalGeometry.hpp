@@ -0,0 +1,364 @@
+#ifndef INCREMENTAL_GEOMETRY_HPP
+#define INCREMENTAL_GEOMETRY_HPP
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "1_core_graph/GridHashMap.hpp"
+#include "1_core_graph/IntGraph.hpp"
+#include "1_core_graph/MakeBaseGraph.hpp"
+#include "3_geometry/PreparedTemplates.hpp"
+#include "3_geometry/DualGraph.hpp" // DualGraphStats
+
+/**
+ * @brief 面のキー (並べ替えて重複を除いた量子化座標の列) に通し番号を振る表
+ * キーは1本の平坦な配列に詰めて持ち、開番地法 (線形探査) で引きます。登録したキーは削除しません。
+ */
+class FaceKeyTable {
+public:
+    /**
+     * @brief キーの番号を返します (未登録なら新しい番号で登録)。points は並べ替え・重複除去済みであること。
+     */
+    int intern(const std::vector<GridPoint3D>& points) {
+        if ((hashes_.size() + 1) * 2 > slots_.size()) grow();
+        uint64_t h = hashPoints(points);
+        size_t mask = slots_.size() - 1;
+        for (size_t i = h & mask;; i = (i + 1) & mask) {
+            int id = slots_[i];
+            if (id < 0) {
+                id = static_cast<int>(hashes_.size());
+                slots_[i] = id;
+                hashes_.push_back(h);
+                points_.insert(points_.end(), points.begin(), points.end());
+                offsets_.push_back(static_cast<int>(points_.size()));
+                return id;
+            }
+            if (hashes_[id] == h && equals(id, points)) return id;
+        }
+    }
+
+    int size() const { return static_cast<int>(hashes_.size()); }
+
+private:
+    static uint64_t hashPoints(const std::vector<GridPoint3D>& points) {
+        uint64_t h = mixHash64(static_cast<uint64_t>(points.size()));
+        for (const GridPoint3D& p : points) h = mixHash64(h ^ GridPointHasher()(p));
+        return h;
+    }
+
+    bool equals(int id, const std::vector<GridPoint3D>& points) const {
+        if (offsets_[id + 1] - offsets_[id] != static_cast<int>(points.size())) return false;
+        return std::equal(points.begin(), points.end(), points_.begin() + offsets_[id]);
+    }
+
+    // 負荷率を 1/2 以下に保つよう容量を2倍にして再挿入
+    void grow() {
+        std::vector<int> old_slots(slots_.empty() ? 16 : slots_.size() * 2, -1);
+        old_slots.swap(slots_);
+        size_t mask = slots_.size() - 1;
+        for (int id = 0; id < size(); ++id) {
+            size_t i = hashes_[id] & mask;
+            while (slots_[i] >= 0) i = (i + 1) & mask;
+            slots_[i] = id;
+        }
+    }
+
+    std::vector<GridPoint3D> points_;
+    std::vector<int> offsets_{0};
+    std::vector<uint64_t> hashes_;
+    std::vector<int> slots_;
+};
+
+/**
+ * @brief 探索パスに沿って増分的に保守する、解の統合メッシュの状態 (接合面の相殺と双対グラフの隣接)
+ *
+ * pushPart で格子頂点1つ分のテンプレートの面を加え、popPart で最後に加えた部品を取り消します (後入れ先出し)。
+ * buildSolutionMesh + buildDualGraph と同じ規則で、
+ *   - 量子化座標の集合が一致する面が2枚以上あれば、それらはすべて接合面として取り除かれ、
+ *   - 取り除かれていない面ちょうど2枚が共有する辺ごとに、双対グラフの辺が張られます。
+ * 面の生存状態、辺ごとの生存面数、双対グラフの辺 (面の組ごとの共有辺の数) と頂点数は
+ * 部品の追加・取り消しのたびに更新するため、1回の push/pop の手間は その部品の面と辺の数に比例します
+ * (解全体の大きさには依存しません)。dualGraph() は保守している辺の列を写すだけです。
+ *
+ * 部品ごとの面キー・辺の番号は初回に計算して使い回します。1スレッドで使うこと (探索のワーカーごとに1つ)。
+ * 双対グラフの頂点ID は 追加順の面の通し番号で、buildDualGraph の面番号とは異なります (同型にはなる)。
+ */
+class IncrementalSolutionGeometry {
+public:
+    IncrementalSolutionGeometry(const GraphData& base_data, const PreparedTemplates& templates)
+        : base_data_(base_data), templates_(templates) {}
+
+    /**
+     * @brief 格子頂点 (コアID * タイプ数 + タイプ番号) のテンプレートの面を加えます。
+     * メッシュの無いタイプの頂点は面を持たない部品として積みます (hasMissingMesh で確認できる)。
+     */
+    void pushPart(int base_vertex_id) {
+        int part_id = partFor(base_vertex_id);
+        const PartGeometry& part = parts_[part_id];
+        frames_.push_back({part_id, static_cast<int>(face_part_.size())});
+        if (part.missing) missing_parts_++;
+
+        for (int f = 0; f < static_cast<int>(part.face_keys.size()); ++f) {
+            int slot = static_cast<int>(face_part_.size());
+            face_part_.push_back(part_id);
+            face_local_.push_back(f);
+            face_live_.push_back(0);
+            face_degree_.push_back(0);
+            for (int k = part.edge_offsets[f]; k < part.edge_offsets[f + 1]; ++k) {
+                edge_faces_[part.edges[k]].push_back(slot);
+            }
+
+            int key = part.face_keys[f];
+            int count = ++key_count_[key];
+            if (count == 1) {
+                key_first_face_[key] = slot;
+                setLive(slot, true);
+            } else if (count == 2) {
+                setLive(key_first_face_[key], false); // 接合面: 先に加えた面も取り除く
+                removed_faces_ += 2;
+            } else {
+                removed_faces_ += 1;
+            }
+        }
+    }
+
+    /**
+     * @brief 最後に加えた部品を取り消します (undo ログ = 部品のスタックを逆順にたどる)。
+     */
+    void popPart() {
+        Frame frame = frames_.back();
+        frames_.pop_back();
+        const PartGeometry& part = parts_[frame.part_id];
+        if (part.missing) missing_parts_--;
+
+        for (int f = static_cast<int>(part.face_keys.size()) - 1; f >= 0; --f) {
+            int slot = frame.first_face + f;
+            int key = part.face_keys[f];
+            int count = key_count_[key]--;
+            if (count == 1) {
+                setLive(slot, false);
+            } else if (count == 2) {
+                setLive(key_first_face_[key], true); // 相手がいなくなったので、先に加えた面が復活
+                removed_faces_ -= 2;
+            } else {
+                removed_faces_ -= 1;
+            }
+            for (int k = part.edge_offsets[f + 1] - 1; k >= part.edge_offsets[f]; --k) {
+                edge_faces_[part.edges[k]].pop_back();
+            }
+        }
+        face_part_.resize(frame.first_face);
+        face_local_.resize(frame.first_face);
+        face_live_.resize(frame.first_face);
+        face_degree_.resize(frame.first_face); // (取り除いた面はすでに死んでいて、双対グラフの辺を持たない)
+    }
+
+    int partCount() const { return static_cast<int>(frames_.size()); }
+    bool hasMissingMesh() const { return missing_parts_ > 0; }
+    // 接合面として取り除かれている面の数 (markCoincidentFaces の戻り値と同じ)
+    long long removedFaceCount() const { return removed_faces_; }
+
+    /**
+     * @brief 現在の部品集合の双対グラフを書き出します (手間は双対グラフの辺の数に比例)。
+     * 辺の向きは buildIntGraph と同じく (辺の列に先に現れた頂点, 後に現れた頂点) です。
+     */
+    IntGraph dualGraph(DualGraphStats* stats = nullptr) const {
+        IntGraph g;
+        g.id_bound = static_cast<int>(face_part_.size());
+        g.num_vertices = dual_vertices_;
+        g.edges.reserve(dual_pairs_.size());
+        first_seen_.resize(face_part_.size(), -1);
+        int next = 0;
+        for (int pair_id : dual_pairs_) {
+            int u = pair_faces_[pair_id].first;
+            int v = pair_faces_[pair_id].second;
+            if (first_seen_[u] < 0) first_seen_[u] = next++;
+            if (first_seen_[v] < 0) first_seen_[v] = next++;
+            if (first_seen_[u] > first_seen_[v]) std::swap(u, v);
+            g.edges.push_back({u, v});
+        }
+        for (const auto& edge : g.edges) {
+            first_seen_[edge.first] = -1;
+            first_seen_[edge.second] = -1;
+        }
+        if (stats) stats->non_manifold_edges += non_manifold_edges_;
+        return g;
+    }
+
+private:
+    // 部品 (平行移動済みのテンプレート) の面キーと、面ごとの辺 (辺の番号, 出現順)
+    struct PartGeometry {
+        bool missing = false;
+        std::vector<int> face_keys;
+        std::vector<int> edge_offsets{0};
+        std::vector<int> edges;
+    };
+    struct Frame {
+        int part_id;
+        int first_face;
+    };
+
+    int partFor(int base_vertex_id) {
+        auto found = part_index_.tryEmplace(static_cast<uint64_t>(base_vertex_id), static_cast<int>(parts_.size()));
+        if (found.second) parts_.push_back(preparePart(base_vertex_id));
+        return found.first;
+    }
+
+    // 部品の面キーと辺を計算 (appendInstance / buildDualGraph と同じ量子化)
+    PartGeometry preparePart(int base_vertex_id) {
+        PartGeometry part;
+        int num_types = static_cast<int>(base_data_.vertex_types.size());
+        int template_id = templates_.template_of_type[base_vertex_id % num_types];
+        if (template_id < 0) {
+            part.missing = true;
+            return part;
+        }
+        TemplateInstance instance{template_id, base_vertex_id / num_types};
+        PackedMesh mesh;
+        std::vector<GridPoint3D> grid_vertices;
+        appendInstance(templates_, base_data_, instance, mesh, grid_vertices);
+
+        std::vector<int> position(mesh.vertexSize());
+        for (int v = 0; v < mesh.vertexSize(); ++v) {
+            int next_id = static_cast<int>(position_to_id_.size());
+            position[v] = position_to_id_.tryEmplace(quantize(mesh.vertex(v)), next_id).first;
+        }
+
+        std::vector<GridPoint3D> key;
+        for (int f = 0; f < mesh.faceSize(); ++f) {
+            FaceRange face = mesh.face(f);
+            key.clear();
+            for (int idx : face) key.push_back(grid_vertices[idx]);
+            std::sort(key.begin(), key.end());
+            key.erase(std::unique(key.begin(), key.end()), key.end());
+            int key_id = face_keys_.intern(key);
+            if (key_id == static_cast<int>(key_count_.size())) {
+                key_count_.push_back(0);
+                key_first_face_.push_back(-1);
+            }
+            part.face_keys.push_back(key_id);
+
+            for (int j = 0; j < face.size(); ++j) {
+                int p1 = position[face[j]];
+                int p2 = position[face[(j + 1) % face.size()]];
+                uint64_t edge_key = (static_cast<uint64_t>(std::min(p1, p2)) << 32) | static_cast<uint32_t>(std::max(p1, p2));
+                auto edge = edge_to_id_.tryEmplace(edge_key, static_cast<int>(edge_faces_.size()));
+                if (edge.second) {
+                    edge_faces_.emplace_back();
+                    edge_live_count_.push_back(0);
+                    edge_pair_.push_back(-1);
+                }
+                part.edges.push_back(edge.first);
+            }
+            part.edge_offsets.push_back(static_cast<int>(part.edges.size()));
+        }
+        return part;
+    }
+
+    // 面の生存状態を切り替え、その面の辺の生存面数を更新
+    void setLive(int slot, bool live) {
+        face_live_[slot] = live ? 1 : 0;
+        const PartGeometry& part = parts_[face_part_[slot]];
+        int f = face_local_[slot];
+        for (int k = part.edge_offsets[f]; k < part.edge_offsets[f + 1]; ++k) {
+            adjustEdge(part.edges[k], live ? 1 : -1);
+        }
+    }
+
+    // 辺の生存面数を delta だけ変え、「ちょうど2面が共有する辺」が結ぶ面の組と非多様体辺の数を保守
+    // (呼ぶ前に face_live_ は更新済みであること)
+    void adjustEdge(int edge, int delta) {
+        int before = edge_live_count_[edge];
+        int after = before + delta;
+        edge_live_count_[edge] = after;
+        if (before == 2 && edge_pair_[edge] >= 0) {
+            releasePair(edge_pair_[edge]);
+            edge_pair_[edge] = -1;
+        }
+        if (after == 2) {
+            int faces[2], n = 0;
+            for (int slot : edge_faces_[edge]) {
+                if (face_live_[slot] && n < 2) faces[n++] = slot;
+            }
+            // (同じ面が同じ辺を2度持つ場合は自己ループなので、buildIntGraph と同じく辺にしない)
+            if (faces[0] != faces[1]) edge_pair_[edge] = acquirePair(faces[0], faces[1]);
+        }
+        if (before > 2) non_manifold_edges_--;
+        if (after > 2) non_manifold_edges_++;
+    }
+
+    // 面の組 (u, v) を結ぶ共有辺を1本増やし、0本から1本になれば双対グラフの辺の列に加える
+    int acquirePair(int u, int v) {
+        if (u > v) std::swap(u, v);
+        uint64_t key = (static_cast<uint64_t>(u) << 32) | static_cast<uint32_t>(v);
+        auto found = pair_index_.tryEmplace(key, static_cast<int>(pair_faces_.size()));
+        int pair_id = found.first;
+        if (found.second) {
+            pair_faces_.push_back({u, v});
+            pair_multiplicity_.push_back(0);
+            pair_position_.push_back(-1);
+        }
+        if (pair_multiplicity_[pair_id]++ == 0) {
+            pair_position_[pair_id] = static_cast<int>(dual_pairs_.size());
+            dual_pairs_.push_back(pair_id);
+            if (face_degree_[u]++ == 0) dual_vertices_++;
+            if (face_degree_[v]++ == 0) dual_vertices_++;
+        }
+        return pair_id;
+    }
+
+    // 面の組を結ぶ共有辺を1本減らし、0本になれば双対グラフの辺の列から外す (末尾と入れ替え)
+    void releasePair(int pair_id) {
+        if (--pair_multiplicity_[pair_id] > 0) return;
+        int pos = pair_position_[pair_id];
+        int last = dual_pairs_.back();
+        dual_pairs_[pos] = last;
+        pair_position_[last] = pos;
+        dual_pairs_.pop_back();
+        pair_position_[pair_id] = -1;
+        if (--face_degree_[pair_faces_[pair_id].first] == 0) dual_vertices_--;
+        if (--face_degree_[pair_faces_[pair_id].second] == 0) dual_vertices_--;
+    }
+
+    const GraphData& base_data_;
+    const PreparedTemplates& templates_;
+
+    // 部品ごとの前計算 (格子頂点ID -> parts_ の添字)
+    OpenAddressingMap<uint64_t, int, UInt64Hasher> part_index_;
+    std::vector<PartGeometry> parts_;
+    OpenAddressingMap<GridPoint3D, int, GridPointHasher> position_to_id_;
+    OpenAddressingMap<uint64_t, int, UInt64Hasher> edge_to_id_;
+    FaceKeyTable face_keys_;
+
+    // 面キーごと: 現在その キーを持つ面の数と、最初に加えた面
+    std::vector<int> key_count_;
+    std::vector<int> key_first_face_;
+
+    // 辺ごと: その辺を持つ面 (出現ごと, 追加順), 生存面の出現数, 生存面ちょうど2つが共有していれば その面の組
+    std::vector<std::vector<int>> edge_faces_;
+    std::vector<int> edge_live_count_;
+    std::vector<int> edge_pair_;
+    long long non_manifold_edges_ = 0;
+
+    // 面の組 (小さい面番号, 大きい面番号) ごと: 共有辺の数と dual_pairs_ 内の位置 (面番号は再利用されるので組も使い回す)
+    OpenAddressingMap<uint64_t, int, UInt64Hasher> pair_index_;
+    std::vector<std::pair<int, int>> pair_faces_;
+    std::vector<int> pair_multiplicity_;
+    std::vector<int> pair_position_;
+    std::vector<int> dual_pairs_; // 双対グラフの辺 (共有辺が1本以上ある面の組)
+    int dual_vertices_ = 0;       // 双対グラフの辺に現れる面の数
+    mutable std::vector<int> first_seen_; // dualGraph() の作業領域 (面番号 -> 辺の列での初出順, 未出は -1)
+    long long removed_faces_ = 0; // 同じキーの面が2枚以上ある面の数
+
+    // 面 (追加順の通し番号) ごと: 部品, 部品内の面番号, 生存しているか, 双対グラフでの次数
+    std::vector<int> face_part_;
+    std::vector<int> face_local_;
+    std::vector<uint8_t> face_live_;
+    std::vector<int> face_degree_;
+
+    std::vector<Frame> frames_;
+    int missing_parts_ = 0;
+};
+
+#endif // INCREMENTAL_GEOMETRY_HPP
@@ -0,0 +1,186 @@
+#ifndef LATTICE_SYMMETRY_HPP
+#define LATTICE_SYMMETRY_HPP
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <cmath>
+
+#include "1_core_graph/MakeBaseGraph.hpp"
+#include "3_geometry/ObjTypes.hpp"
+
+// 3x3 行列 (行優先)
+using Matrix3 = std::vector<std::vector<double>>;
+
+// ヘルパー: 行列とベクトルの積
+inline Point3D applyMatrix(const Matrix3& m, const Point3D& p) {
+    return {
+        m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z,
+        m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z,
+        m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z
+    };
+}
+
+// ヘルパー: 外積
+inline Point3D crossProduct(const Point3D& a, const Point3D& b) {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+// ヘルパー: 列ベクトル (a1, a2, a3) を並べた行列の逆行列 (特異なら false)
+inline bool invertColumns(const Point3D& a1, const Point3D& a2, const Point3D& a3, Matrix3& inv) {
+    Point3D c23 = crossProduct(a2, a3);
+    double det = a1.x * c23.x + a1.y * c23.y + a1.z * c23.z;
+    if (std::fabs(det) < 1e-9) return false;
+    Point3D c31 = crossProduct(a3, a1);
+    Point3D c12 = crossProduct(a1, a2);
+    // 逆行列の各行は (a2×a3, a3×a1, a1×a2) / det
+    inv = {
+        {c23.x / det, c23.y / det, c23.z / det},
+        {c31.x / det, c31.y / det, c31.z / det},
+        {c12.x / det, c12.y / det, c12.z / det}
+    };
+    return true;
+}
+
+// ヘルパー: R = [b1 b2 b3] * [a1 a2 a3]^-1
+inline bool solveLinearMap(
+    const Point3D& a1, const Point3D& a2, const Point3D& a3,
+    const Point3D& b1, const Point3D& b2, const Point3D& b3,
+    Matrix3& r
+) {
+    Matrix3 inv;
+    if (!invertColumns(a1, a2, a3, inv)) return false;
+    const Point3D cols[3] = {b1, b2, b3};
+    r.assign(3, std::vector<double>(3, 0.0));
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            double sum = 0.0;
+            for (int k = 0; k < 3; ++k) {
+                const Point3D& b = cols[k];
+                double bi = (i == 0) ? b.x : (i == 1) ? b.y : b.z;
+                sum += bi * inv[k][j];
+            }
+            r[i][j] = sum;
+        }
+    }
+    return true;
+}
+
+// ヘルパー: 量子化座標が一致するか
+inline bool sameGridPoint(const Point3D& p, const Point3D& q) {
+    GridPoint3D a = quantize(p);
+    GridPoint3D b = quantize(q);
+    return a.x_grid == b.x_grid && a.y_grid == b.y_grid && a.z_grid == b.z_grid;
+}
+
+/**
+ * @brief 行列 R が直交行列で、コア座標の対応と全タイプのメッシュを保つかを検証します。
+ */
+inline bool isMeshPreservingIsometry(
+    const Matrix3& r,
+    const std::vector<std::pair<Point3D, Point3D>>& core_pairs,
+    const std::map<std::string, ObjMesh>& mesh_data
+) {
+    // 1. 直交性 (R^T R = I)
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            double dot = r[0][i] * r[0][j] + r[1][i] * r[1][j] + r[2][i] * r[2][j];
+            if (std::fabs(dot - (i == j ? 1.0 : 0.0)) > 1e-6) return false;
+        }
+    }
+
+    // 2. すべてのコア座標が対応先に移る
+    for (const auto& pair : core_pairs) {
+        if (!sameGridPoint(applyMatrix(r, pair.first), pair.second)) return false;
+    }
+
+    // 3. 各タイプのテンプレートメッシュが (面単位で) 自分自身に移る
+    for (const auto& type_mesh : mesh_data) {
+        const ObjMesh& mesh = type_mesh.second;
+        std::set<std::set<GridPoint3D>> faces;
+        for (const auto& face : mesh.faces) {
+            std::set<GridPoint3D> key;
+            for (int idx : face) key.insert(quantize(mesh.vertices.at(idx)));
+            faces.insert(key);
+        }
+        for (const auto& face : mesh.faces) {
+            std::set<GridPoint3D> key;
+            for (int idx : face) key.insert(quantize(applyMatrix(r, mesh.vertices.at(idx))));
+            if (faces.count(key) == 0) return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief コアIDの対応 (core_map) が、原点を固定する格子の等長変換で、
+ * かつ全タイプのテンプレートメッシュを保つものとして実現できるかを判定します。
+ *
+ * true の場合、解 S とその像 core_map(S) のメッシュは合同になるため、双対グラフも同型になります。
+ * (探索の対称性枝刈りは、この判定を通過した自己同型だけを使います)
+ */
+inline bool isLatticeIsometry(
+    const std::map<int, int>& core_map,
+    const GraphData& base_data,
+    const std::map<std::string, ObjMesh>& mesh_data
+) {
+    // 1. 対応するコア座標のペアを集める
+    std::vector<std::pair<Point3D, Point3D>> core_pairs;
+    bool is_identity = true;
+    int num_cores = static_cast<int>(base_data.core_locations.size());
+    for (const auto& pair : core_map) {
+        if (pair.first < 0 || pair.first >= num_cores || pair.second < 0 || pair.second >= num_cores) return false;
+        core_pairs.push_back({base_data.core_locations[pair.first], base_data.core_locations[pair.second]});
+        if (pair.first != pair.second) is_identity = false;
+    }
+
+    // 2. 線形独立なコア座標を最大3つ選ぶ
+    std::vector<int> basis;
+    for (size_t i = 0; i < core_pairs.size() && basis.size() < 3; ++i) {
+        const Point3D& a = core_pairs[i].first;
+        bool independent = false;
+        if (basis.empty()) {
+            independent = std::sqrt(a.x * a.x + a.y * a.y + a.z * a.z) > 1e-6;
+        } else if (basis.size() == 1) {
+            Point3D c = crossProduct(core_pairs[basis[0]].first, a);
+            independent = std::sqrt(c.x * c.x + c.y * c.y + c.z * c.z) > 1e-6;
+        } else {
+            Point3D c = crossProduct(core_pairs[basis[0]].first, core_pairs[basis[1]].first);
+            independent = std::fabs(c.x * a.x + c.y * a.y + c.z * a.z) > 1e-6;
+        }
+        if (independent) basis.push_back(static_cast<int>(i));
+    }
+
+    // 3. 候補となる線形写像 R を作り、検証する
+    std::vector<Matrix3> candidates;
+    if (basis.size() == 3) {
+        Matrix3 r;
+        if (solveLinearMap(core_pairs[basis[0]].first, core_pairs[basis[1]].first, core_pairs[basis[2]].first,
+                           core_pairs[basis[0]].second, core_pairs[basis[1]].second, core_pairs[basis[2]].second, r)) {
+            candidates.push_back(r);
+        }
+    } else if (basis.size() == 2) {
+        // 平面格子: 法線方向は向きを保つ/反転する の2通りを試す
+        const Point3D& a1 = core_pairs[basis[0]].first;
+        const Point3D& a2 = core_pairs[basis[1]].first;
+        const Point3D& b1 = core_pairs[basis[0]].second;
+        const Point3D& b2 = core_pairs[basis[1]].second;
+        Point3D a3 = crossProduct(a1, a2);
+        Point3D b3 = crossProduct(b1, b2);
+        Point3D b3_flipped = {-b3.x, -b3.y, -b3.z};
+        Matrix3 r;
+        if (solveLinearMap(a1, a2, a3, b1, b2, b3, r)) candidates.push_back(r);
+        if (solveLinearMap(a1, a2, a3, b1, b2, b3_flipped, r)) candidates.push_back(r);
+    } else if (is_identity) {
+        // 直線状/単一コアの格子では恒等写像のみ扱う
+        return true;
+    }
+
+    for (const Matrix3& r : candidates) {
+        if (isMeshPreservingIsometry(r, core_pairs, mesh_data)) return true;
+    }
+    return false;
+}
+
+#endif // LATTICE_SYMMETRY_HPP
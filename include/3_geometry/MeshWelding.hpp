@@ -0,0 +1,39 @@
+#ifndef MESH_WELDING_HPP
+#define MESH_WELDING_HPP
+
+#include <vector>
+
+#include "1_core_graph/GridHashMap.hpp"
+#include "1_core_graph/MakeBaseGraph.hpp" // GridPoint3D, GridPointHasher
+#include "3_geometry/ObjTypes.hpp"
+
+/**
+ * @brief 量子化座標が同じ頂点を1つにまとめ (溶接)、どの面からも使われない頂点を取り除きます。
+ * 頂点は面から最初に参照された順に並べ直し、座標は最初に参照された頂点のものを使います。
+ * 溶接後は頂点ID が量子化座標と1対1に対応するため、mesh.welded を true にします。
+ * grid_vertices は溶接前の各頂点の量子化座標です。戻り値は取り除いた頂点の数です。
+ */
+inline int weldVertices(PackedMesh& mesh, const std::vector<GridPoint3D>& grid_vertices) {
+    const int old_size = mesh.vertexSize();
+    std::vector<int> new_index(old_size, -1);
+    OpenAddressingMap<GridPoint3D, int, GridPointHasher> position_to_vertex(old_size);
+
+    PackedMesh welded;
+    welded.reserve(old_size, 0, 0);
+    for (int& idx : mesh.face_indices) {
+        if (new_index[idx] < 0) {
+            auto found = position_to_vertex.tryEmplace(grid_vertices[idx], welded.vertexSize());
+            if (found.second) welded.addVertex(mesh.vertex(idx));
+            new_index[idx] = found.first;
+        }
+        idx = new_index[idx];
+    }
+
+    mesh.xs.swap(welded.xs);
+    mesh.ys.swap(welded.ys);
+    mesh.zs.swap(welded.zs);
+    mesh.welded = true;
+    return old_size - mesh.vertexSize();
+}
+
+#endif // MESH_WELDING_HPP
@@ -17,4 +17,85 @@ struct ObjMesh {
     std::vector<std::vector<int>> faces; 
 };
 
-#endif // OBJ_TYPES_HPP
\ No newline at end of file
+/**
+ * @brief 面の頂点番号の範囲 (PackedMesh::face の戻り値)
+ */
+struct FaceRange {
+    const int* first;
+    const int* last;
+    const int* begin() const { return first; }
+    const int* end() const { return last; }
+    int size() const { return static_cast<int>(last - first); }
+    int operator[](int k) const { return first[k]; }
+};
+
+/**
+ * @brief 平坦化したメッシュ (形状処理の段で使う表現)
+ * 頂点座標は軸ごとの配列 (SoA)、面は CSR 形式 (face_offsets + face_indices) で持つため、
+ * 面の数によらずメッシュ1つあたりの確保は定数回で済みます。
+ * face_tags は任意で、空でなければ面ごとの付加情報 (その面を生んだ格子頂点のID など, 無ければ -1) です。
+ * 空でない face_tags の要素数は常に面の数と同じです。
+ * welded が true なら、量子化座標の同じ頂点は1つにまとめられています (頂点ID で位置を比較できる)。
+ */
+struct PackedMesh {
+    std::vector<double> xs, ys, zs;
+    std::vector<int> face_offsets{0}; // 面 f の頂点は face_indices[face_offsets[f] .. face_offsets[f+1])
+    std::vector<int> face_indices;
+    std::vector<int> face_tags;
+    bool welded = false;
+
+    int vertexSize() const { return static_cast<int>(xs.size()); }
+    int faceSize() const { return static_cast<int>(face_offsets.size()) - 1; }
+    bool hasFaceTags() const { return !face_tags.empty(); }
+
+    Point3D vertex(int v) const { return {xs[v], ys[v], zs[v]}; }
+    FaceRange face(int f) const {
+        return {face_indices.data() + face_offsets[f], face_indices.data() + face_offsets[f + 1]};
+    }
+
+    void addVertex(const Point3D& p) {
+        xs.push_back(p.x);
+        ys.push_back(p.y);
+        zs.push_back(p.z);
+    }
+    // face_indices の末尾に頂点番号を積んだ後で呼び、そこまでを1つの面として閉じる
+    void closeFace() { face_offsets.push_back(static_cast<int>(face_indices.size())); }
+
+    void reserve(int num_vertices, int num_faces, int num_indices) {
+        xs.reserve(num_vertices);
+        ys.reserve(num_vertices);
+        zs.reserve(num_vertices);
+        face_offsets.reserve(num_faces + 1);
+        face_indices.reserve(num_indices);
+    }
+};
+
+// アダプタ: ObjMesh (ローダーの出力) -> PackedMesh
+inline PackedMesh packMesh(const ObjMesh& mesh) {
+    PackedMesh packed;
+    size_t num_indices = 0;
+    for (const auto& face : mesh.faces) num_indices += face.size();
+    packed.reserve(static_cast<int>(mesh.vertices.size()), static_cast<int>(mesh.faces.size()),
+                   static_cast<int>(num_indices));
+    for (const Point3D& v : mesh.vertices) packed.addVertex(v);
+    for (const auto& face : mesh.faces) {
+        packed.face_indices.insert(packed.face_indices.end(), face.begin(), face.end());
+        packed.closeFace();
+    }
+    return packed;
+}
+
+// アダプタ: PackedMesh -> ObjMesh (面ごとの vector が必要な既存コード向け)
+inline ObjMesh unpackMesh(const PackedMesh& packed) {
+    ObjMesh mesh;
+    mesh.vertices.reserve(packed.vertexSize());
+    for (int v = 0; v < packed.vertexSize(); ++v) mesh.vertices.push_back(packed.vertex(v));
+    mesh.faces.reserve(packed.faceSize());
+    for (int f = 0; f < packed.faceSize(); ++f) {
+        FaceRange face = packed.face(f);
+        mesh.faces.emplace_back(face.begin(), face.end());
+    }
+    return mesh;
+}
+
+#endif // OBJ_TYPES_HPP
@@ -0,0 +1,146 @@
+#ifndef PREPARED_TEMPLATES_HPP
+#define PREPARED_TEMPLATES_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <stdexcept>
+
+#include "3_geometry/ObjTypes.hpp"
+#include "1_core_graph/MakeBaseGraph.hpp" // GraphData, quantize
+
+/**
+ * @brief 前処理済みのテンプレートメッシュ (頂点タイプごとに1つ)
+ * 面は (オフセット, 頂点番号) の平坦な配列で持ち、頂点の量子化座標はテンプレート原点基準で事前に計算しておきます。
+ */
+struct PreparedTemplate {
+    PackedMesh mesh;                        // テンプレート原点基準のメッシュ
+    std::vector<GridPoint3D> grid_vertices; // quantize(mesh.vertex(i))
+};
+
+/**
+ * @brief 平行移動したテンプレートのビュー (テンプレート番号 + コアID)
+ * 頂点はコピーせず、materializeInstance / appendInstance で必要になった時点で書き出します。
+ */
+struct TemplateInstance {
+    int template_id;
+    int core_id;
+};
+
+/**
+ * @brief 全タイプの前処理済みテンプレート (解の間で共有し、読み取り専用で使う)
+ */
+struct PreparedTemplates {
+    std::vector<PreparedTemplate> templates;
+    std::vector<int> template_of_type; // タイプ番号 -> テンプレート番号 (メッシュが無ければ -1)
+};
+
+// ヘルパー: 座標の各成分がグリッド (TOLERANCE の整数倍) 上にあるか
+inline bool isOnGrid(const Point3D& p) {
+    const double eps = 1e-9;
+    auto on_grid = [eps](double value) {
+        double scaled = value * QUANTIZATION_FACTOR;
+        return std::fabs(scaled - std::round(scaled)) < eps;
+    };
+    return on_grid(p.x) && on_grid(p.y) && on_grid(p.z);
+}
+
+/**
+ * @brief タイプ別メッシュ定義から前処理済みテンプレートを作ります (解ごとではなく、実行中に1回だけ呼ぶ)。
+ * タイプ番号は base_data.vertex_types の順です。
+ */
+inline PreparedTemplates prepareTemplates(
+    const GraphData& base_data,
+    const std::map<std::string, ObjMesh>& mesh_data
+) {
+    PreparedTemplates prepared;
+    prepared.template_of_type.assign(base_data.vertex_types.size(), -1);
+    for (size_t t = 0; t < base_data.vertex_types.size(); ++t) {
+        auto it = mesh_data.find(base_data.vertex_types[t]);
+        if (it == mesh_data.end()) continue;
+        const ObjMesh& mesh = it->second;
+
+        PreparedTemplate tmpl;
+        tmpl.mesh = packMesh(mesh);
+        tmpl.grid_vertices.reserve(mesh.vertices.size());
+        for (const Point3D& v : mesh.vertices) tmpl.grid_vertices.push_back(quantize(v));
+
+        prepared.template_of_type[t] = static_cast<int>(prepared.templates.size());
+        prepared.templates.push_back(std::move(tmpl));
+    }
+    return prepared;
+}
+
+/**
+ * @brief 格子の頂点ID (コアID * タイプ数 + タイプ番号) に対応するテンプレートのビューを返します。
+ */
+inline TemplateInstance instanceForVertex(
+    const PreparedTemplates& prepared,
+    const GraphData& base_data,
+    int vertex_id
+) {
+    int num_types = static_cast<int>(base_data.vertex_types.size());
+    int type_index = vertex_id % num_types;
+    int template_id = prepared.template_of_type[type_index];
+    if (template_id < 0) {
+        throw std::runtime_error("Error: No mesh data found for type: " + base_data.vertex_types[type_index]);
+    }
+    return {template_id, vertex_id / num_types};
+}
+
+/**
+ * @brief インスタンスの頂点と面を、統合メッシュの末尾に直接書き出します。
+ * grid_vertices には各頂点の量子化座標を追記します (コアがグリッド上にあれば整数の足し算で求める)。
+ * face_tag が 0 以上なら、追加した面すべてにそのタグを付けます。
+ * face_tags は常に「空」か「面と同じ数」です: タグ付きの追加が混ざると、タグの無い面には -1 を入れます。
+ */
+inline void appendInstance(
+    const PreparedTemplates& prepared,
+    const GraphData& base_data,
+    const TemplateInstance& instance,
+    PackedMesh& merged_mesh,
+    std::vector<GridPoint3D>& grid_vertices,
+    int face_tag = -1
+) {
+    const PackedMesh& tmpl = prepared.templates[instance.template_id].mesh;
+    const std::vector<GridPoint3D>& tmpl_grid = prepared.templates[instance.template_id].grid_vertices;
+    const Point3D& translation = base_data.core_locations[instance.core_id];
+    const int vertex_offset = merged_mesh.vertexSize();
+    const int face_offset = merged_mesh.faceSize();
+
+    for (int v = 0; v < tmpl.vertexSize(); ++v) merged_mesh.addVertex(tmpl.vertex(v) + translation);
+    if (isOnGrid(translation)) {
+        const GridPoint3D offset = quantize(translation);
+        for (const GridPoint3D& g : tmpl_grid) {
+            grid_vertices.push_back({g.x_grid + offset.x_grid, g.y_grid + offset.y_grid, g.z_grid + offset.z_grid});
+        }
+    } else {
+        // グリッド外のコア: 平行移動後の座標を量子化し直す
+        for (int v = vertex_offset; v < merged_mesh.vertexSize(); ++v) {
+            grid_vertices.push_back(quantize(merged_mesh.vertex(v)));
+        }
+    }
+
+    for (int idx : tmpl.face_indices) merged_mesh.face_indices.push_back(idx + vertex_offset);
+    const int index_offset = merged_mesh.face_offsets.back();
+    for (int f = 1; f <= tmpl.faceSize(); ++f) merged_mesh.face_offsets.push_back(tmpl.face_offsets[f] + index_offset);
+    if (face_tag >= 0 && merged_mesh.face_tags.empty()) merged_mesh.face_tags.assign(face_offset, -1);
+    if (!merged_mesh.face_tags.empty()) merged_mesh.face_tags.insert(merged_mesh.face_tags.end(), tmpl.faceSize(), face_tag);
+}
+
+/**
+ * @brief インスタンスを単独のメッシュとして実体化します (getMeshForVertex と同じ結果)。
+ */
+inline PackedMesh materializeInstance(
+    const PreparedTemplates& prepared,
+    const GraphData& base_data,
+    const TemplateInstance& instance
+) {
+    PackedMesh mesh;
+    std::vector<GridPoint3D> grid_vertices;
+    appendInstance(prepared, base_data, instance, mesh, grid_vertices);
+    return mesh;
+}
+
+#endif // PREPARED_TEMPLATES_HPP
@@ -5,83 +5,119 @@
 #include <vector>
 #include <set>
 #include <map>
+#include <stdexcept>
 #include <iostream> // std::cerr のため
 #include <ostream> // <-- 【追加】 std::ostream のため
 
 #include "3_geometry/ObjTypes.hpp"
 #include "1_core_graph/MakeBaseGraph.hpp" 
+#include "1_core_graph/Instrumentation.hpp"
+#include "1_core_graph/Logging.hpp"
 #include "3_geometry/VertexMesh.hpp"      
+#include "3_geometry/PreparedTemplates.hpp"
+#include "3_geometry/CoincidentFaces.hpp"
+#include "3_geometry/MeshWelding.hpp"
 #include "9_export/ExportGraph.hpp"      
 
-using FaceKey = std::set<GridPoint3D>;
+/**
+ * @brief buildSolutionMesh のオプション
+ */
+struct SolutionMeshOptions {
+    bool weld_vertices = false; // 同じ位置の頂点をまとめ、使われない頂点を取り除く (OBJ が小さくなる)
+};
 
-// --- ▼ 【修正】 関数シグネチャと std::cerr -> log_stream ▼ ---
-inline ObjMesh buildSolutionMesh(
+/**
+ * @brief 解 (頂点セット) の各頂点のテンプレートを平行移動して統合し、接合面を取り除いたメッシュを作ります。
+ * テンプレートは prepareTemplates で前処理したものを使い、統合メッシュへ直接書き出します。
+ * 各面のタグ (face_tags) は、その面を生んだ格子頂点のIDです。
+ */
+inline PackedMesh buildSolutionMesh(
     const std::set<std::string>& solution,
     const GraphData& base_data,
-    const std::map<std::string, ObjMesh>& mesh_data,
-    std::ostream& log_stream // <-- 【追加】
+    const PreparedTemplates& templates,
+    std::ostream& log_stream,
+    const SolutionMeshOptions& options = SolutionMeshOptions()
 ) {
-    ObjMesh merged_mesh;
-    int vertex_offset = 0;
+    ScopedPhase phase(Phase::MeshBuild);
 
-    // 1. メッシュの統合
+    // 1. 頂点名 -> テンプレートのビュー (統合後の大きさを先に求めて、確保を1回で済ませる)
+    std::vector<TemplateInstance> instances;
+    std::vector<int> vertex_ids;
+    instances.reserve(solution.size());
+    vertex_ids.reserve(solution.size());
+    int num_vertices = 0, num_faces = 0, num_indices = 0;
     for (const std::string& vertex_name : solution) {
-        ObjMesh mesh_part = getMeshForVertex(vertex_name, base_data, mesh_data);
-        merged_mesh.vertices.insert(
-            merged_mesh.vertices.end(),
-            mesh_part.vertices.begin(),
-            mesh_part.vertices.end()
-        );
-        for (const auto& face : mesh_part.faces) {
-            std::vector<int> offset_face;
-            for (int idx : face) {
-                offset_face.push_back(idx + vertex_offset);
-            }
-            merged_mesh.faces.push_back(offset_face);
+        int vertex_id = findBaseVertex(base_data, vertex_name);
+        if (vertex_id < 0) {
+            throw std::runtime_error("Error: Invalid vertex name format: " + vertex_name);
         }
-        vertex_offset += mesh_part.vertices.size();
+        instances.push_back(instanceForVertex(templates, base_data, vertex_id));
+        vertex_ids.push_back(vertex_id);
+        const PackedMesh& tmpl = templates.templates[instances.back().template_id].mesh;
+        num_vertices += tmpl.vertexSize();
+        num_faces += tmpl.faceSize();
+        num_indices += static_cast<int>(tmpl.face_indices.size());
     }
-    
-    log_stream << "  Merged solution mesh: " << merged_mesh.vertices.size() 
-              << " vertices, " << merged_mesh.faces.size() << " faces (before cleaning)." << std::endl;
-
-    // 2. 接合面の削除
-    std::map<FaceKey, std::vector<int>> face_map;
-    for (int i = 0; i < merged_mesh.faces.size(); ++i) {
-        const auto& face_indices = merged_mesh.faces[i];
-        FaceKey key;
-        for (int idx : face_indices) {
-            key.insert(quantize(merged_mesh.vertices[idx]));
-        }
-        face_map[key].push_back(i);
+
+    // 2. メッシュの統合
+    PackedMesh mesh;
+    mesh.reserve(num_vertices, num_faces, num_indices);
+    mesh.face_tags.reserve(num_faces);
+    std::vector<GridPoint3D> grid_vertices; // mesh の頂点の量子化座標
+    grid_vertices.reserve(num_vertices);
+    for (size_t i = 0; i < instances.size(); ++i) {
+        appendInstance(templates, base_data, instances[i], mesh, grid_vertices, vertex_ids[i]);
     }
+    
+    GR_LOG(log_stream, LogLevel::Debug, LogSubsystem::Geometry,
+           "  Merged solution mesh: " << mesh.vertexSize()
+           << " vertices, " << mesh.faceSize() << " faces (before cleaning)." << '\n');
 
-    std::set<int> faces_to_delete;
-    for (const auto& pair : face_map) {
-        if (pair.second.size() > 1) { 
-            faces_to_delete.insert(pair.second.begin(), pair.second.end());
-        }
+    // 3. 接合面の削除
+    std::vector<bool> to_delete;
+    int num_deleted = markCoincidentFaces(mesh, grid_vertices, to_delete);
+    addCounter(Counter::CoincidentFacesRemoved, num_deleted);
+
+    if (num_deleted > 0) {
+        GR_LOG(log_stream, LogLevel::Debug, LogSubsystem::Geometry,
+               "  Cleaning mesh: Found and marked " << num_deleted << " coincident faces for deletion." << '\n');
     }
 
-    if (!faces_to_delete.empty()) {
-        log_stream << "  Cleaning mesh: Found and marked " 
-                  << faces_to_delete.size() << " coincident faces for deletion." << std::endl;
+    // 4. 削除されなかった面をその場で詰める
+    int kept_faces = 0, kept_indices = 0;
+    for (int i = 0; i < mesh.faceSize(); ++i) {
+        if (to_delete[i]) continue;
+        int begin = mesh.face_offsets[i], end = mesh.face_offsets[i + 1];
+        for (int k = begin; k < end; ++k) mesh.face_indices[kept_indices++] = mesh.face_indices[k];
+        mesh.face_tags[kept_faces] = mesh.face_tags[i];
+        mesh.face_offsets[++kept_faces] = kept_indices;
     }
+    mesh.face_offsets.resize(kept_faces + 1);
+    mesh.face_indices.resize(kept_indices);
+    mesh.face_tags.resize(kept_faces);
 
-    // 3. クリーニング済みメッシュの作成
-    ObjMesh final_mesh;
-    final_mesh.vertices = merged_mesh.vertices; 
-    for (int i = 0; i < merged_mesh.faces.size(); ++i) {
-        if (faces_to_delete.count(i) == 0) {
-            final_mesh.faces.push_back(merged_mesh.faces[i]);
-        }
+    // 5. (オプション) 頂点の溶接と、使われない頂点の削除
+    if (options.weld_vertices) {
+        int num_removed = weldVertices(mesh, grid_vertices);
+        GR_LOG(log_stream, LogLevel::Debug, LogSubsystem::Geometry,
+               "  Welded mesh: removed " << num_removed << " duplicate or unused vertices." << '\n');
     }
     
-    log_stream << "  Built final mesh: " << final_mesh.vertices.size() 
-              << " vertices, " << final_mesh.faces.size() << " faces." << std::endl;
+    GR_LOG(log_stream, LogLevel::Debug, LogSubsystem::Geometry,
+           "  Built final mesh: " << mesh.vertexSize() << " vertices, " << mesh.faceSize() << " faces." << '\n');
               
-    return final_mesh;
+    return mesh;
+}
+
+// (テンプレートを前処理していない呼び出し元向け。解を多数処理する場合は PreparedTemplates を使い回すこと)
+inline PackedMesh buildSolutionMesh(
+    const std::set<std::string>& solution,
+    const GraphData& base_data,
+    const std::map<std::string, ObjMesh>& mesh_data,
+    std::ostream& log_stream,
+    const SolutionMeshOptions& options = SolutionMeshOptions()
+) {
+    return buildSolutionMesh(solution, base_data, prepareTemplates(base_data, mesh_data), log_stream, options);
 }
 
 
@@ -103,7 +139,7 @@ inline void exportSolutionMesh(
     }
     
     // 1. 内部関数でメッシュを構築
-    ObjMesh final_mesh = buildSolutionMesh(solution, base_data, mesh_data, log_stream); 
+    PackedMesh final_mesh = buildSolutionMesh(solution, base_data, mesh_data, log_stream); 
 
     // 2. ファイルに出力
     // --- ▼ 【修正】 log_stream を渡す ▼ ---
@@ -55,10 +55,10 @@ inline ObjMesh getMeshForVertex(
     const ObjMesh& template_mesh = mesh_data.at(base_type);
 
     // 3. 該当するコアの座標 (平行移動量) を探す
-    if (base_data.core_locations.count(core_id) == 0) {
+    if (core_id < 0 || core_id >= static_cast<int>(base_data.core_locations.size())) {
         throw std::runtime_error("Error: No location data found for core ID: " + std::to_string(core_id));
     }
-    const Point3D& translation = base_data.core_locations.at(core_id);
+    const Point3D& translation = base_data.core_locations[core_id];
 
     // 4. 新しいメッシュ (コピー) を作成
     ObjMesh translated_mesh = template_mesh; // (面情報はそのままコピーされる)
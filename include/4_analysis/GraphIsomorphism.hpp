@@ -9,8 +9,13 @@
 #include <sstream> // std::stringstream
 #include <cstring> // C言語のメモリ操作 (malloc) のため
 #include <algorithm> // std::sort
+#include <tuple>
+#include <mutex>
+#include <utility>
 
-#include "tdzdd/util/Graph.hpp"
+#include "1_core_graph/IntGraph.hpp"
+#include "1_core_graph/Instrumentation.hpp"
+#include "1_core_graph/NautyLock.hpp"
 
 // C++コードから C言語の nauty ヘッダをインクルードする
 extern "C" {
@@ -20,53 +25,36 @@ extern "C" {
 }
 
 /**
- * @brief tdzdd::Graph を nauty が要求する sparsegraph (sg) 形式に変換します。
- * (Segmentation Fault 対策で、2パスアルゴリズムに完全書き換え)
+ * @brief IntGraph を nauty が要求する sparsegraph (sg) 形式に変換します。
+ * nauty の頂点ID は辺に現れた順に 0, 1, ... と詰めて割り当てます (辺に現れない頂点IDは含めない)。
+ * 頂点名を経由しないので、文字列の生成や std::map の検索は行いません。
  */
 inline void convertToSparseGraph(
-    const tdzdd::Graph& g,
+    const IntGraph& g,
     sparsegraph& sg,
     std::vector<int>& lab,
     std::vector<int>& ptn,
-    std::vector<int>& orbits,
-    std::map<std::string, int>& vertex_to_int
+    std::vector<int>& orbits
 ) {
-    int v_count_tdzdd = g.vertexSize();
     int e_count = g.edgeSize();
-    
-    // --- パス 1: C++ の隣接リストと頂点マップを作成 ---
-    int next_int_id = 0;
-    // (nauty の頂点ID -> nauty の隣接リスト)
-    std::map<int, std::vector<int>> adj_list_int; 
-
-    for (int i = 0; i < e_count; ++i) {
-        const auto& edge = g.edgeInfo(i);
-        std::string name1 = g.vertexName(edge.v1);
-        std::string name2 = g.vertexName(edge.v2);
-
-        // 頂点名 ("0", "1"...) を nauty の ID (0, 1...) にマッピング
-        if (vertex_to_int.count(name1) == 0) vertex_to_int[name1] = next_int_id++;
-        if (vertex_to_int.count(name2) == 0) vertex_to_int[name2] = next_int_id++;
-
-        int u = vertex_to_int[name1];
-        int v = vertex_to_int[name2];
-        
-        // C++の隣接リストに (u, v) と (v, u) の両方を追加
-        adj_list_int[u].push_back(v);
-        adj_list_int[v].push_back(u);
-    }
-    
-    // 孤立点もマッピングに追加
-    for (int v_tdzdd = 1; v_tdzdd <= v_count_tdzdd; ++v_tdzdd) {
-         std::string name = g.vertexName(v_tdzdd);
-         if (vertex_to_int.count(name) == 0) {
-             vertex_to_int[name] = next_int_id++;
-         }
+
+    // --- パス 1: 頂点ID -> nauty の頂点ID と 次数 ---
+    std::vector<int> vertex_to_int(g.idBound(), -1);
+    std::vector<int> degree;
+    degree.reserve(g.vertexSize());
+    for (const auto& edge : g.edges) {
+        for (int v : {edge.first, edge.second}) {
+            if (vertex_to_int[v] < 0) {
+                vertex_to_int[v] = static_cast<int>(degree.size());
+                degree.push_back(0);
+            }
+            degree[vertex_to_int[v]]++;
+        }
     }
 
-    int v_count = vertex_to_int.size();
+    int v_count = static_cast<int>(degree.size());
+    SG_INIT(sg);
     if (v_count == 0) {
-        SG_INIT(sg);
         return;
     }
 
@@ -74,99 +62,135 @@ inline void convertToSparseGraph(
     ptn.resize(v_count);
     orbits.resize(v_count);
 
-    // --- パス 2: nauty の sparsegraph 構造体を正しく構築 ---
-    SG_INIT(sg);
+    // --- パス 2: nauty の sparsegraph 構造体を構築 ---
     SG_ALLOC(sg, v_count, e_count * 2, "malloc");
     sg.nv = v_count; 
     sg.nde = e_count * 2;
 
-    int k = 0; // sg.e 配列用のグローバルインデックス
-    
-    // v_count (nauty の頂点数 0 から n-1) でループ
+    size_t k = 0; // sg.e 配列用のグローバルインデックス
     for (int i = 0; i < v_count; ++i) {
         sg.v[i] = k; // 頂点 i の隣接リストは sg.e[k] から始まる
-        
-        if (adj_list_int.count(i)) { 
-            // 頂点 i に隣接する頂点 (neighbor) が存在する場合
-            auto& neighbors = adj_list_int.at(i);
-            
-            // nauty の要求仕様: 隣接リストはソートされている必要がある
-            std::sort(neighbors.begin(), neighbors.end());
-            
-            sg.d[i] = neighbors.size(); // 頂点 i の次数
-            
-            // ソート済みの隣接リストを sg.e にコピー
-            for (int neighbor : neighbors) {
-                sg.e[k] = neighbor;
-                k++;
-            }
-        } else {
-            // 孤立点の場合
-            sg.d[i] = 0;
-        }
+        sg.d[i] = 0;
+        k += degree[i];
+    }
+    for (const auto& edge : g.edges) {
+        int u = vertex_to_int[edge.first];
+        int v = vertex_to_int[edge.second];
+        sg.e[sg.v[u] + sg.d[u]++] = v;
+        sg.e[sg.v[v] + sg.d[v]++] = u;
+    }
+
+    // nauty の要求仕様: 隣接リストはソートされている必要がある
+    for (int i = 0; i < v_count; ++i) {
+        std::sort(sg.e + sg.v[i], sg.e + sg.v[i] + sg.d[i]);
     }
-    // (この時点で k == e_count * 2 となるはず)
 }
 
 
 /**
- * @brief nauty を呼び出し、グラフの正規形 (Canonical Label) を文字列として取得します。
- * (変更なし)
+ * @brief グラフの正規形 (nauty の正規ラベリング後の辺集合)
+ * 同型なグラフの正規形は完全に一致します。辺 (i, j) は i < j で、辞書順に並びます。
  */
-inline std::string getCanonicalLabel(const tdzdd::Graph& g) {
-    
+struct CanonicalForm {
+    int num_vertices = 0;
+    std::vector<std::pair<int, int>> edges;
+
+    bool operator==(const CanonicalForm& other) const {
+        return num_vertices == other.num_vertices && edges == other.edges;
+    }
+    bool operator<(const CanonicalForm& other) const {
+        return std::tie(num_vertices, edges) < std::tie(other.num_vertices, other.edges);
+    }
+};
+
+/**
+ * @brief nauty を1回だけ呼び出し、グラフの正規形を取得します (複数スレッドから呼び出し可能)。
+ */
+inline CanonicalForm computeCanonicalForm(const IntGraph& g) {
+    CanonicalForm form;
+
     sparsegraph sg;
     std::vector<int> lab, ptn, orbits;
-    std::map<std::string, int> vertex_to_int;
 
-    // 1. TdZddグラフを nauty の sparsegraph 形式に変換
-    convertToSparseGraph(g, sg, lab, ptn, orbits, vertex_to_int);
+    // 1. IntGraph を nauty の sparsegraph 形式に変換
+    convertToSparseGraph(g, sg, lab, ptn, orbits);
 
     int v_count = sg.nv;
     if (v_count == 0) {
         SG_FREE(sg); // 空でも SG_ALLOC が呼ばれている可能性があるので解放
-        return "empty";
+        return form;
     }
 
     sparsegraph canong;
     SG_INIT(canong);
 
-    static DEFAULTOPTIONS_SPARSEGRAPH(options);
+    DEFAULTOPTIONS_SPARSEGRAPH(options);
     options.getcanon = TRUE; 
     options.writeautoms = FALSE; 
     
     statsblk stats; 
 
     // 2. nauty (sparsenauty) の呼び出し
-    sparsenauty(&sg, lab.data(), ptn.data(), orbits.data(), &options, &stats, &canong);
+    {
+#ifndef USE_TLS
+        std::lock_guard<std::mutex> lock(nautyMutex());
+#endif
+        ScopedPhase phase(Phase::Nauty); // (ロック待ちは含めない)
+        sparsenauty(&sg, lab.data(), ptn.data(), orbits.data(), &options, &stats, &canong);
+        addCounter(Counter::NautyCalls, 1);
+    }
 
-    // 3. 正規グラフ (canong) を一意な文字列に変換
-    std::stringstream ss;
-    ss << "v:" << canong.nv << " e:" << (canong.nde / 2) << " edges:";
-    
-    // sparsenauty が生成した canong はソート済みとは限らないため、
-    // 一意な文字列を生成するためにソートする
-    sortlists_sg(&canong); 
-    
+    // 3. 正規グラフ (canong) を (i < j) の辺のソート済みリストにする
+    // (sparsenauty が生成した canong の隣接リストはソート済みとは限らない)
+    form.num_vertices = canong.nv;
+    form.edges.reserve(canong.nde / 2);
     for (int i = 0; i < canong.nv; ++i) {
-        ss << " " << i << ":[";
-        std::vector<int> neighbors;
         for (int j = 0; j < canong.d[i]; ++j) {
-            neighbors.push_back(canong.e[canong.v[i] + j]);
-        }
-        std::sort(neighbors.begin(), neighbors.end()); 
-        
-        for (size_t j = 0; j < neighbors.size(); ++j) {
-            ss << neighbors[j] << (j == neighbors.size() - 1 ? "" : ",");
+            int neighbor = canong.e[canong.v[i] + j];
+            if (i < neighbor) form.edges.push_back({i, neighbor});
         }
-        ss << "]";
     }
+    std::sort(form.edges.begin(), form.edges.end());
     
     // 4. メモリ解放
     SG_FREE(sg); 
     SG_FREE(canong);
 
-    return ss.str(); 
+    return form;
+}
+
+/**
+ * @brief 正規形を一意な文字列 (正規ラベル) に変換します。
+ * 形式は "v:頂点数 e:辺数 edges: 0:[隣接頂点,...] 1:[...] ..." (空グラフは "empty")
+ */
+inline std::string formatCanonicalLabel(const CanonicalForm& form) {
+    if (form.num_vertices == 0) {
+        return "empty";
+    }
+    std::vector<std::vector<int>> neighbors(form.num_vertices);
+    for (const auto& edge : form.edges) {
+        neighbors[edge.first].push_back(edge.second);
+        neighbors[edge.second].push_back(edge.first);
+    }
+
+    std::stringstream ss;
+    ss << "v:" << form.num_vertices << " e:" << form.edges.size() << " edges:";
+    for (int i = 0; i < form.num_vertices; ++i) {
+        std::sort(neighbors[i].begin(), neighbors[i].end());
+        ss << " " << i << ":[";
+        for (size_t j = 0; j < neighbors[i].size(); ++j) {
+            ss << neighbors[i][j] << (j == neighbors[i].size() - 1 ? "" : ",");
+        }
+        ss << "]";
+    }
+    return ss.str();
+}
+
+/**
+ * @brief nauty を呼び出し、グラフの正規形 (Canonical Label) を文字列として取得します。
+ */
+inline std::string getCanonicalLabel(const IntGraph& g) {
+    return formatCanonicalLabel(computeCanonicalForm(g));
 }
 
 
@@ -174,10 +198,10 @@ inline std::string getCanonicalLabel(const tdzdd::Graph& g) {
  * @brief 双対グラフのリストを受け取り、nauty の正規形に基づいてユニークなグラフを抽出します。
  * (変更なし)
  */
-inline std::map<std::string, tdzdd::Graph> filterUniqueGraphsNauty(
-    const std::vector<tdzdd::Graph>& all_graphs
+inline std::map<std::string, IntGraph> filterUniqueGraphsNauty(
+    const std::vector<IntGraph>& all_graphs
 ) {
-    std::map<std::string, tdzdd::Graph> unique_graphs;
+    std::map<std::string, IntGraph> unique_graphs;
 
     for (const auto& g : all_graphs) {
         std::string key = getCanonicalLabel(g);
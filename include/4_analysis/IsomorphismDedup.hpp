@@ -0,0 +1,240 @@
+#ifndef ISOMORPHISM_DEDUP_HPP
+#define ISOMORPHISM_DEDUP_HPP
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+#include "1_core_graph/GridHashMap.hpp"
+#include "1_core_graph/IntGraph.hpp"
+#include "4_analysis/GraphIsomorphism.hpp"
+
+/**
+ * @brief 正規形の 128bit ハッシュ
+ */
+struct CanonicalHash {
+    uint64_t lo = 0;
+    uint64_t hi = 0;
+    bool operator==(const CanonicalHash& other) const {
+        return lo == other.lo && hi == other.hi;
+    }
+};
+
+struct CanonicalHashHasher {
+    uint64_t operator()(const CanonicalHash& h) const { return h.lo; }
+};
+
+/**
+ * @brief 正規形の 128bit ハッシュを計算します (種の異なる2本の 64bit ハッシュ)。
+ */
+inline CanonicalHash hashCanonicalForm(const CanonicalForm& form) {
+    CanonicalHash h;
+    h.lo = mixHash64(0x9e3779b97f4a7c15ULL ^ static_cast<uint64_t>(form.num_vertices));
+    h.hi = mixHash64(0xc2b2ae3d27d4eb4fULL + static_cast<uint64_t>(form.edges.size()));
+    for (const auto& edge : form.edges) {
+        uint64_t word = (static_cast<uint64_t>(edge.first) << 32) | static_cast<uint32_t>(edge.second);
+        h.lo = mixHash64(h.lo ^ word);
+        h.hi = mixHash64(h.hi + word * 0xff51afd7ed558ccdULL);
+    }
+    return h;
+}
+
+/**
+ * @brief グラフの不変量による指紋 (同型なグラフは必ず同じ指紋を持つ)
+ * 頂点数・辺数と、1ラウンドの Weisfeiler-Lehman 彩色 (次数 + 隣接頂点の次数の多重集合) の多重集合から作ります。
+ * 多重集合は順序に依存しない和で畳み込むので、ソートは不要です (O(V + E))。
+ */
+inline CanonicalHash computeGraphFingerprint(const IntGraph& g) {
+    std::vector<int> degree(g.idBound(), 0);
+    for (const auto& edge : g.edges) {
+        degree[edge.first]++;
+        degree[edge.second]++;
+    }
+    std::vector<uint64_t> neighbor_sum(g.idBound(), 0);
+    for (const auto& edge : g.edges) {
+        neighbor_sum[edge.first] += mixHash64(static_cast<uint64_t>(degree[edge.second]));
+        neighbor_sum[edge.second] += mixHash64(static_cast<uint64_t>(degree[edge.first]));
+    }
+
+    CanonicalHash fingerprint;
+    fingerprint.lo = mixHash64(0x9e3779b97f4a7c15ULL ^ static_cast<uint64_t>(g.vertexSize()));
+    fingerprint.hi = mixHash64(0xc2b2ae3d27d4eb4fULL + static_cast<uint64_t>(g.edgeSize()));
+    uint64_t color_sum_lo = 0, color_sum_hi = 0;
+    for (int v = 0; v < g.idBound(); ++v) {
+        if (degree[v] == 0) continue;
+        uint64_t color = mixHash64(neighbor_sum[v] ^ (static_cast<uint64_t>(degree[v]) << 48));
+        color_sum_lo += color;
+        color_sum_hi += mixHash64(color ^ 0xff51afd7ed558ccdULL);
+    }
+    fingerprint.lo = mixHash64(fingerprint.lo ^ color_sum_lo);
+    fingerprint.hi = mixHash64(fingerprint.hi ^ color_sum_hi);
+    return fingerprint;
+}
+
+/**
+ * @brief 同型判定による重複除去テーブル (不変量による事前振り分け付き)
+ *
+ * 1. まず安価な指紋 (computeGraphFingerprint) でグラフをバケットに振り分ける
+ *    - 指紋が異なるグラフは同型でないので、バケットの最初のグラフは nauty を呼ばずに新しい同型類として登録する
+ * 2. バケットに2つ目のグラフが来た時点で、そのバケットのグラフだけを nauty で正規化する
+ *    - 正規形の 128bit ハッシュをキーにハッシュ表で引き、一致したら正規形どうしを完全比較する
+ *      (ハッシュ衝突で別のグラフを同一視することはありません)
+ *
+ * 同型類ごとに「代表の番号」(呼び出し側の解の通し番号など) を保持します。
+ */
+class IsomorphismDedup {
+public:
+    struct InsertResult {
+        size_t class_id; // 同型類の番号 (0 から登録順)
+        bool inserted;   // 新しい同型類として登録したか
+    };
+
+    // バケットの最初の類の、遅延している正規化 (呼び出し側がロックの外で nauty を呼ぶため)
+    struct DeferredCanonicalisation {
+        bool pending = false; // 段階1で、最初の類がまだ正規化されていなかったか
+        IntGraph graph;       // その類のグラフ (の写し)
+        CanonicalForm form;   // 呼び出し側で求めた graph の正規形
+    };
+
+    /**
+     * @brief グラフを登録します。既知の同型類なら、その番号を返します。
+     * 新しい同型類の代表は representative になります (既存の類の代表は変更しません)。
+     */
+    InsertResult insert(const IntGraph& g, size_t representative) {
+        CanonicalHash fingerprint = computeGraphFingerprint(g);
+        size_t class_id;
+        if (insertIfNewFingerprint(g, fingerprint, representative, class_id)) {
+            return {class_id, true};
+        }
+        return insertCanonical(fingerprint, computeCanonicalForm(g), representative);
+    }
+
+    /**
+     * @brief (段階1) 指紋が新しければ、nauty を呼ばずに新しい同型類として登録して true を返します。
+     * false の場合は、呼び出し側で正規形を求めて insertCanonical を呼んでください
+     * (正規化をロックの外で行えるように、登録を2段階に分けています)。
+     * deferred を渡すと、バケットの最初の類がまだ正規化されていない場合にそのグラフを写します。
+     * 呼び出し側はその正規形も deferred->form に求めてから insertCanonical に渡してください。
+     */
+    bool insertIfNewFingerprint(
+        const IntGraph& g,
+        const CanonicalHash& fingerprint,
+        size_t representative,
+        size_t& class_id,
+        DeferredCanonicalisation* deferred = nullptr
+    ) {
+        insertions_++;
+        auto bucket = buckets_.tryEmplace(fingerprint, classes_.size());
+        if (!bucket.second) {
+            if (deferred && !classes_[bucket.first].canonical) {
+                deferred->pending = true;
+                deferred->graph = classes_[bucket.first].graph;
+            }
+            return false;
+        }
+        // 正規化は必要になるまで遅延
+        classes_.push_back({CanonicalForm(), false, g, representative, kNone});
+        class_id = classes_.size() - 1;
+        return true;
+    }
+
+    /**
+     * @brief (段階2) 指紋が既知のグラフを、呼び出し側で求めた正規形で登録します。
+     * deferred は段階1で受け取ったものです (最初の類の正規形を求め済みなら、nauty を呼び直さずに使う)。
+     */
+    InsertResult insertCanonical(
+        const CanonicalHash& fingerprint,
+        CanonicalForm form,
+        size_t representative,
+        DeferredCanonicalisation* deferred = nullptr
+    ) {
+        canonicalisations_++;
+
+        // バケットの最初の類がまだ正規化されていなければ、ここで正規化して登録
+        // (段階1との間に別のスレッドが正規化していれば、deferred の正規形は使わずに捨てる)
+        const size_t* first_in_bucket = buckets_.find(fingerprint);
+        if (first_in_bucket && !classes_[*first_in_bucket].canonical) {
+            if (deferred && deferred->pending) {
+                setCanonical(*first_in_bucket, std::move(deferred->form));
+            } else {
+                setCanonical(*first_in_bucket, computeCanonicalForm(classes_[*first_in_bucket].graph));
+            }
+        }
+
+        size_t found = findCanonical(form);
+        if (found != kNone) return {found, false};
+
+        classes_.push_back({std::move(form), true, IntGraph(), representative, kNone});
+        registerCanonical(classes_.size() - 1);
+        return {classes_.size() - 1, true};
+    }
+
+    size_t size() const { return classes_.size(); }
+    size_t representative(size_t class_id) const { return classes_[class_id].representative; }
+    void setRepresentative(size_t class_id, size_t representative) { classes_[class_id].representative = representative; }
+
+    /**
+     * @brief 同型類の正規形を返します (未正規化なら、ここで初めて nauty を呼びます)。
+     */
+    const CanonicalForm& canonicalForm(size_t class_id) {
+        if (!classes_[class_id].canonical) setCanonical(class_id, computeCanonicalForm(classes_[class_id].graph));
+        return classes_[class_id].form;
+    }
+
+    long long insertions() const { return insertions_; }               // 登録されたグラフの数
+    long long canonicalisations() const { return canonicalisations_; } // nauty の呼び出し回数
+    long long skippedCanonicalisations() const { return insertions_ - canonicalisations_; } // 指紋だけで判定できた回数
+    long long hashCollisions() const { return hash_collisions_; }      // 完全比較で別の類と判明した回数
+
+private:
+    static constexpr size_t kNone = static_cast<size_t>(-1);
+
+    struct IsomorphismClass {
+        CanonicalForm form;
+        bool canonical;        // form が計算済みか
+        IntGraph graph;        // 正規化を遅延している間だけ保持するグラフ
+        size_t representative;
+        size_t next_same_hash; // 同じ正規形ハッシュを持つ次の類 (無ければ kNone)
+    };
+
+    // 遅延していた正規化の結果を記録し、正規形のハッシュ表に登録
+    void setCanonical(size_t class_id, CanonicalForm form) {
+        IsomorphismClass& c = classes_[class_id];
+        c.form = std::move(form);
+        c.canonical = true;
+        c.graph = IntGraph();
+        canonicalisations_++;
+        registerCanonical(class_id);
+    }
+
+    // 正規形のハッシュ表に登録 (同じハッシュの類がある場合は連結リストの末尾に繋ぐ)
+    void registerCanonical(size_t class_id) {
+        auto head = heads_.tryEmplace(hashCanonicalForm(classes_[class_id].form), class_id);
+        if (head.second) return;
+        size_t id = head.first;
+        while (classes_[id].next_same_hash != kNone) id = classes_[id].next_same_hash;
+        classes_[id].next_same_hash = class_id;
+    }
+
+    // 正規形が一致する類を探す (無ければ kNone)
+    size_t findCanonical(const CanonicalForm& form) {
+        const size_t* head = heads_.find(hashCanonicalForm(form));
+        if (!head) return kNone;
+        for (size_t id = *head; id != kNone; id = classes_[id].next_same_hash) {
+            if (classes_[id].form == form) return id;
+            hash_collisions_++;
+        }
+        return kNone;
+    }
+
+    OpenAddressingMap<CanonicalHash, size_t, CanonicalHashHasher> buckets_; // 指紋 -> バケットの最初の類
+    OpenAddressingMap<CanonicalHash, size_t, CanonicalHashHasher> heads_;   // 正規形ハッシュ -> 最初の類
+    std::vector<IsomorphismClass> classes_;
+    long long insertions_ = 0;
+    long long canonicalisations_ = 0;
+    long long hash_collisions_ = 0;
+};
+
+#endif // ISOMORPHISM_DEDUP_HPP
@@ -0,0 +1,416 @@
+#ifndef SOLUTION_PIPELINE_HPP
+#define SOLUTION_PIPELINE_HPP
+
+#include <set>
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <sstream>
+#include <ostream>
+#include <exception>
+#include <functional>
+#include <algorithm>
+
+#include "1_core_graph/MakeBaseGraph.hpp"
+#include "1_core_graph/IntGraph.hpp"
+#include "1_core_graph/Instrumentation.hpp"
+#include "1_core_graph/Logging.hpp"
+#include "2_search/BoundedQueue.hpp"
+#include "2_search/IndexedSearch.hpp"
+#include "3_geometry/ObjTypes.hpp"
+#include "3_geometry/PreparedTemplates.hpp"
+#include "3_geometry/SolutionMesh.hpp"
+#include "3_geometry/DualGraph.hpp"
+#include "3_geometry/IncrementalGeometry.hpp"
+#include "4_analysis/IsomorphismDedup.hpp"
+
+/**
+ * @brief 同型類ごとの代表解と、その双対グラフ・メッシュ
+ * メッシュは代表解のものだけを保持するため、出力時にメッシュを作り直す必要はありません。
+ * (代表でないと分かった解のメッシュはその場で破棄するので、保持するメッシュの数は同型類の数で抑えられます)
+ */
+struct UniqueGraphEntry {
+    std::set<std::string> representative_solution;
+    IntGraph dual_graph;
+    PackedMesh mesh;
+};
+
+// 解の順序 (a が b より前なら true)。同型類の代表は、この順序で最初の解になる
+using SolutionOrder = std::function<bool(const std::set<std::string>& a, const std::set<std::string>& b)>;
+
+/**
+ * @brief シャード分割した並行重複除去 (同型類ごとの代表解を集める)
+ * 同型なグラフは必ず同じ指紋を持つので、指紋でシャードを選べばシャード間の照合は不要です。
+ * 代表は「SolutionOrder で最初の解」で、解が届く順序 (スレッドのスケジュール) には依存しません。
+ * nauty による正規化はシャードのロックの外で行います。
+ */
+class ShardedUniqueGraphs {
+public:
+    ShardedUniqueGraphs(size_t num_shards, SolutionOrder solution_order)
+        : shards_(num_shards > 0 ? num_shards : 1), solution_order_(std::move(solution_order)) {}
+
+    /**
+     * @brief 解とその双対グラフ・メッシュを登録します (複数スレッドから呼び出し可能)。
+     */
+    void add(std::set<std::string> solution, IntGraph dual_graph, PackedMesh mesh, const CanonicalHash& fingerprint) {
+        size_t solution_index = next_index_++;
+        Shard& shard = shards_[fingerprint.lo % shards_.size()];
+
+        // 1. 指紋が新しければ nauty を呼ばずに登録
+        IsomorphismDedup::DeferredCanonicalisation deferred;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            size_t class_id;
+            if (shard.dedup.insertIfNewFingerprint(dual_graph, fingerprint, solution_index, class_id, &deferred)) {
+                shard.entries.push_back(UniqueGraphEntry{std::move(solution), std::move(dual_graph), std::move(mesh)});
+                return;
+            }
+        }
+
+        // 2. 正規化 (このグラフと、遅延していたバケットの最初の類のグラフ; どちらもロックの外) してから登録
+        CanonicalForm form = computeCanonicalForm(dual_graph);
+        if (deferred.pending) deferred.form = computeCanonicalForm(deferred.graph);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        IsomorphismDedup::InsertResult result =
+            shard.dedup.insertCanonical(fingerprint, std::move(form), solution_index, &deferred);
+        if (result.inserted) {
+            shard.entries.push_back(UniqueGraphEntry{std::move(solution), std::move(dual_graph), std::move(mesh)});
+            return;
+        }
+        addCounter(Counter::DuplicateHits, 1);
+        if (solution_order_(solution, shard.entries[result.class_id].representative_solution)) {
+            shard.entries[result.class_id] = UniqueGraphEntry{std::move(solution), std::move(dual_graph), std::move(mesh)};
+            shard.dedup.setRepresentative(result.class_id, solution_index);
+        }
+        // (それ以外: 代表でない解のメッシュと双対グラフは、ここで破棄される)
+    }
+
+    /**
+     * @brief 全シャードの同型類を、代表解の順序で並べて取り出します。
+     */
+    std::vector<UniqueGraphEntry> takeSorted() {
+        std::vector<UniqueGraphEntry> entries;
+        for (Shard& shard : shards_) {
+            for (UniqueGraphEntry& entry : shard.entries) entries.push_back(std::move(entry));
+            shard.entries.clear();
+        }
+        std::sort(entries.begin(), entries.end(), [this](const UniqueGraphEntry& a, const UniqueGraphEntry& b) {
+            return solution_order_(a.representative_solution, b.representative_solution);
+        });
+        return entries;
+    }
+
+    /**
+     * @brief すべての同型類の代表を書き換えます (並行する add() が無いときに呼ぶこと)。
+     */
+    template <typename Function>
+    void forEachEntry(Function&& function) {
+        for (Shard& shard : shards_) {
+            for (UniqueGraphEntry& entry : shard.entries) function(entry);
+        }
+    }
+
+    // 統計 (全シャードの合計)
+    long long insertions() const { return sum(&IsomorphismDedup::insertions); }
+    long long canonicalisations() const { return sum(&IsomorphismDedup::canonicalisations); }
+    long long skippedCanonicalisations() const { return sum(&IsomorphismDedup::skippedCanonicalisations); }
+    long long hashCollisions() const { return sum(&IsomorphismDedup::hashCollisions); }
+
+private:
+    struct Shard {
+        std::mutex mutex;
+        IsomorphismDedup dedup;
+        std::vector<UniqueGraphEntry> entries; // 添字: そのシャード内の同型類の番号
+    };
+
+    long long sum(long long (IsomorphismDedup::*stat)() const) const {
+        long long total = 0;
+        for (const Shard& shard : shards_) total += (shard.dedup.*stat)();
+        return total;
+    }
+
+    std::vector<Shard> shards_;
+    SolutionOrder solution_order_;
+    std::atomic<size_t> next_index_{0};
+};
+
+/**
+ * @brief 解の後処理パイプライン: (1) メッシュ構築 → (2) 双対グラフ構築 → (3) 正規化と重複除去
+ *
+ * num_threads == 1 のときは push() の中で全段をその場で実行します (従来どおりの逐次処理)。
+ * num_threads > 1 のときは各段に num_threads 本のワーカーを立て、段の間を容量付きキューで繋ぎます。
+ * 探索 (push の呼び出し側) が後処理より速い場合は、キューが満杯になった時点で push が待つため、
+ * 未処理の解がメモリに溜まり続けることはありません。
+ * ワーカーで例外が起きた場合はパイプラインを中断し、次の push() または finish() で再送出します。
+ * push() の呼び出しは (探索の解シンクと同じく) 直列化されている必要があります。
+ */
+class SolutionPipeline {
+public:
+    SolutionPipeline(
+        const GraphData& base_data,
+        const std::map<std::string, ObjMesh>& mesh_data,
+        std::ostream& log_stream,
+        SolutionOrder solution_order,
+        const SolutionMeshOptions& mesh_options = SolutionMeshOptions(),
+        int num_threads = 1,
+        size_t queue_capacity = 256
+    ) : base_data_(base_data), templates_(prepareTemplates(base_data, mesh_data)), mesh_options_(mesh_options),
+        log_stream_(log_stream),
+        num_threads_(num_threads > 0 ? num_threads : 1),
+        unique_graphs_(num_threads_ > 1 ? 4 * static_cast<size_t>(num_threads_) : 1, std::move(solution_order)),
+        solution_queue_(queue_capacity), mesh_queue_(queue_capacity), dual_queue_(queue_capacity) {
+        if (num_threads_ > 1) startWorkers();
+    }
+
+    ~SolutionPipeline() {
+        abort();
+        joinWorkers();
+    }
+
+    SolutionPipeline(const SolutionPipeline&) = delete;
+    SolutionPipeline& operator=(const SolutionPipeline&) = delete;
+
+    /**
+     * @brief 解を1つ投入します (探索の解シンクから呼ぶ)。
+     */
+    void push(const std::set<std::string>& solution) {
+        if (incremental_) return; // (増分モードでは、解はオブザーバから届く)
+        if (num_threads_ == 1) {
+            PackedMesh mesh = buildSolutionMesh(solution, base_data_, templates_, log_stream_, mesh_options_);
+            IntGraph dual_graph = buildDualGraphCounted(mesh);
+            CanonicalHash fingerprint = computeGraphFingerprint(dual_graph);
+            unique_graphs_.add(solution, std::move(dual_graph), std::move(mesh), fingerprint);
+            return;
+        }
+        flushLog();
+        if (!solution_queue_.push(solution)) rethrowIfFailed();
+    }
+
+    /**
+     * @brief 投入を締め切り、全段の処理が終わるまで待ちます。
+     */
+    void finish() {
+        solution_queue_.close();
+        joinWorkers();
+        flushLog();
+        rethrowIfFailed();
+        if (incremental_) rebuildRepresentativeGeometry();
+    }
+
+    /**
+     * @brief 増分モードに切り替え、探索に渡すオブザーバの生成関数を返します (探索を始める前に呼ぶ)。
+     * 増分モードでは、各解の双対グラフを探索木に沿って増分的に求め (IncrementalSolutionGeometry)、
+     * 解ごとのメッシュ構築と双対グラフ構築を省きます。
+     * 代表解のメッシュと双対グラフは finish() で通常の方法で作り直すため、出力は通常モードと同じです。
+     */
+    SearchPathObserverFactory incrementalGeometry() {
+        incremental_ = true;
+        return [this](const IndexedSearchGraph& g) {
+            return std::unique_ptr<SearchPathObserver>(new IncrementalObserver(*this, g));
+        };
+    }
+
+    ShardedUniqueGraphs& uniqueGraphs() { return unique_graphs_; }
+
+    // 双対グラフ構築で無視した辺の数 (全解の合計)
+    long long nonManifoldEdges() const { return non_manifold_edges_; }
+
+private:
+    // 探索パスに沿って部品を積み下ろしし、解が見つかったら双対グラフを重複除去の段へ渡す
+    class IncrementalObserver : public SearchPathObserver {
+    public:
+        IncrementalObserver(SolutionPipeline& pipeline, const IndexedSearchGraph& g)
+            : pipeline_(pipeline), g_(g), geometry_(pipeline.base_data_, pipeline.templates_) {
+            base_vertex_.reserve(g.names.size());
+            for (const std::string& name : g.names) {
+                base_vertex_.push_back(findBaseVertex(pipeline.base_data_, name));
+            }
+        }
+
+        void pushVertex(int vertex) override { geometry_.pushPart(base_vertex_[vertex]); }
+        void popVertex() override { geometry_.popPart(); }
+
+        void solutionFound(const std::vector<int>& solution) override {
+            std::set<std::string> names = indexedSolutionToNames(g_, solution);
+            if (geometry_.hasMissingMesh()) {
+                // 通常モードと同じエラーにする (メッシュの無いタイプで例外が送出される)
+                buildSolutionMesh(names, pipeline_.base_data_, pipeline_.templates_, nullLogStream());
+            }
+            ScopedPhase dual_phase(Phase::DualBuild);
+            DualGraphStats stats;
+            IntGraph dual_graph = geometry_.dualGraph(&stats);
+            addCounter(Counter::CoincidentFacesRemoved, geometry_.removedFaceCount());
+            dual_phase.stop();
+            pipeline_.addIncremental(std::move(names), std::move(dual_graph), stats);
+        }
+
+    private:
+        SolutionPipeline& pipeline_;
+        const IndexedSearchGraph& g_;
+        IncrementalSolutionGeometry geometry_;
+        std::vector<int> base_vertex_; // 探索グラフの頂点ID -> 格子の頂点ID
+    };
+
+    // (増分モード) 探索スレッドから呼ばれる: 重複除去の段へ渡す
+    void addIncremental(std::set<std::string> solution, IntGraph dual_graph, const DualGraphStats& stats) {
+        non_manifold_edges_ += stats.non_manifold_edges;
+        CanonicalHash fingerprint = computeGraphFingerprint(dual_graph);
+        if (num_threads_ == 1) {
+            unique_graphs_.add(std::move(solution), std::move(dual_graph), PackedMesh(), fingerprint);
+            return;
+        }
+        if (!dual_queue_.push(DualItem{std::move(solution), std::move(dual_graph), PackedMesh(), fingerprint})) {
+            rethrowIfFailed();
+        }
+    }
+
+    // (増分モード) 代表解のメッシュと双対グラフを通常の方法で作り直す (出力を通常モードと揃える)
+    // 接合面の数は solutionFound で解ごとに数え済みなので、作り直した分はカウンタから差し引く
+    void rebuildRepresentativeGeometry() {
+        const long long counted_faces = counterValue(Counter::CoincidentFacesRemoved);
+        unique_graphs_.forEachEntry([this](UniqueGraphEntry& entry) {
+            entry.mesh = buildSolutionMesh(entry.representative_solution, base_data_, templates_, log_stream_, mesh_options_);
+            entry.dual_graph = buildDualGraph(entry.mesh);
+        });
+        addCounter(Counter::CoincidentFacesRemoved, counted_faces - counterValue(Counter::CoincidentFacesRemoved));
+    }
+
+    struct MeshItem {
+        std::set<std::string> solution;
+        PackedMesh mesh;
+    };
+    struct DualItem {
+        std::set<std::string> solution;
+        IntGraph dual_graph;
+        PackedMesh mesh;
+        CanonicalHash fingerprint;
+    };
+
+    // 双対グラフを構築し、非多様体辺の数を集計
+    IntGraph buildDualGraphCounted(const PackedMesh& mesh) {
+        DualGraphStats stats;
+        IntGraph dual_graph = buildDualGraph(mesh, &stats);
+        non_manifold_edges_ += stats.non_manifold_edges;
+        return dual_graph;
+    }
+
+    // ワーカーを起動 (各段の最後のワーカーが終わったら次の段のキューを締め切る)
+    void startWorkers() {
+        auto mesh_remaining = std::make_shared<std::atomic<int>>(num_threads_);
+        auto dual_remaining = std::make_shared<std::atomic<int>>(num_threads_);
+        for (int t = 0; t < num_threads_; ++t) {
+            workers_.emplace_back([this, mesh_remaining] {
+                runStage([this] {
+                    std::set<std::string> solution;
+                    const bool log_items = GR_LOG_ENABLED(LogLevel::Debug, LogSubsystem::Geometry);
+                    while (solution_queue_.pop(solution)) {
+                        if (!log_items) {
+                            PackedMesh mesh = buildSolutionMesh(solution, base_data_, templates_, nullLogStream(), mesh_options_);
+                            if (!mesh_queue_.push(MeshItem{std::move(solution), std::move(mesh)})) return;
+                            continue;
+                        }
+                        std::ostringstream item_log; // 解ごとのログをまとめて書き出す (行が混ざらないように)
+                        PackedMesh mesh = buildSolutionMesh(solution, base_data_, templates_, item_log, mesh_options_);
+                        writeLog(item_log.str());
+                        if (!mesh_queue_.push(MeshItem{std::move(solution), std::move(mesh)})) return;
+                    }
+                });
+                if (--*mesh_remaining == 0) mesh_queue_.close();
+            });
+            workers_.emplace_back([this, dual_remaining] {
+                runStage([this] {
+                    MeshItem item;
+                    while (mesh_queue_.pop(item)) {
+                        IntGraph dual_graph = buildDualGraphCounted(item.mesh);
+                        CanonicalHash fingerprint = computeGraphFingerprint(dual_graph);
+                        if (!dual_queue_.push(DualItem{std::move(item.solution), std::move(dual_graph),
+                                                       std::move(item.mesh), fingerprint})) return;
+                    }
+                });
+                if (--*dual_remaining == 0) dual_queue_.close();
+            });
+            workers_.emplace_back([this] {
+                runStage([this] {
+                    DualItem item;
+                    while (dual_queue_.pop(item)) {
+                        unique_graphs_.add(std::move(item.solution), std::move(item.dual_graph),
+                                           std::move(item.mesh), item.fingerprint);
+                    }
+                });
+            });
+        }
+    }
+
+    // 段の本体を実行し、例外が起きたら記録してパイプライン全体を中断
+    template <typename Body>
+    void runStage(Body&& body) {
+        try {
+            body();
+        } catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(error_mutex_);
+                if (!error_) error_ = std::current_exception();
+            }
+            abort();
+        }
+    }
+
+    void abort() {
+        solution_queue_.abort();
+        mesh_queue_.abort();
+        dual_queue_.abort();
+    }
+
+    void joinWorkers() {
+        for (std::thread& worker : workers_) {
+            if (worker.joinable()) worker.join();
+        }
+        workers_.clear();
+    }
+
+    void rethrowIfFailed() {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        if (error_) std::rethrow_exception(error_);
+    }
+
+    // ワーカーのログは一旦溜めておき、push()/finish() を呼んだスレッドが log_stream に書き出す
+    // (log_stream は探索側も使うため、ワーカーから直接は書き込まない)
+    void writeLog(const std::string& text) {
+        std::lock_guard<std::mutex> lock(log_mutex_);
+        pending_log_ += text;
+    }
+
+    void flushLog() {
+        std::string text;
+        {
+            std::lock_guard<std::mutex> lock(log_mutex_);
+            text.swap(pending_log_);
+        }
+        log_stream_ << text;
+    }
+
+    const GraphData& base_data_;
+    const PreparedTemplates templates_; // タイプ別テンプレート (全ワーカーで共有, 読み取り専用)
+    const SolutionMeshOptions mesh_options_;
+    std::ostream& log_stream_;
+    int num_threads_;
+    ShardedUniqueGraphs unique_graphs_;
+
+    BoundedQueue<std::set<std::string>> solution_queue_;
+    BoundedQueue<MeshItem> mesh_queue_;
+    BoundedQueue<DualItem> dual_queue_;
+    std::vector<std::thread> workers_;
+
+    bool incremental_ = false;
+    std::atomic<long long> non_manifold_edges_{0};
+    std::mutex log_mutex_;
+    std::string pending_log_;
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+};
+
+#endif // SOLUTION_PIPELINE_HPP
@@ -0,0 +1,159 @@
+#ifndef ASYNC_WRITER_HPP
+#define ASYNC_WRITER_HPP
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <ostream>
+#include <sstream>
+#include <utility>
+
+#include "2_search/BoundedQueue.hpp"
+#include "9_export/BufferedWriter.hpp"
+#include "9_export/ExportGraph.hpp"   // exportWithWriter
+#include "9_export/ResultBundle.hpp"
+
+/**
+ * @brief 書式化済みの出力を専用スレッドで書き出すライタ
+ * 呼び出し側は内容をメモリ上で書式化して submit() で渡すだけで、ファイルへの書き込みを待たずに次の結果へ進めます。
+ * 受け渡しは容量付きキューで、さらに書き込み待ちの合計バイト数を max_pending_bytes までに抑えます
+ * (超える場合は submit が書き込みの進むのを待つため、書き込みが遅くてもメモリは増え続けません)。
+ * bundle を渡すと、ファイルの代わりにそのバンドルへ順に追加します (バンドルはこのライタのスレッドだけが触る)。
+ * 書き込みスレッドのログは溜めておき、submit()/finish() を呼んだスレッドが log_stream に書き出します。
+ * 書き込みスレッドで例外が起きた場合は以降の書き込みを中止し、次の submit() または finish() で再送出します。
+ */
+class AsyncFileWriter {
+public:
+    static constexpr size_t kDefaultMaxPendingBytes = 64u << 20;
+
+    explicit AsyncFileWriter(
+        std::ostream& log_stream,
+        ResultBundleWriter* bundle = nullptr,
+        size_t max_pending_bytes = kDefaultMaxPendingBytes,
+        size_t queue_capacity = 256
+    ) : log_stream_(log_stream), bundle_(bundle), max_pending_bytes_(max_pending_bytes), queue_(queue_capacity) {
+        thread_ = std::thread([this] { run(); });
+    }
+
+    ~AsyncFileWriter() {
+        queue_.abort();
+        wakeSubmitters();
+        if (thread_.joinable()) thread_.join();
+    }
+
+    AsyncFileWriter(const AsyncFileWriter&) = delete;
+    AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+    /**
+     * @brief 書き出しを1つ依頼します。
+     * target はファイル名 (bundle があればエントリ名)、description は書き終えたときのログ
+     * ("<description> was written to <target>", バンドルでは使わない) です。
+     */
+    void submit(std::string target, std::string contents, bool binary, std::string description) {
+        flushLog();
+        const size_t size = contents.size();
+        {
+            std::unique_lock<std::mutex> lock(pending_mutex_);
+            // (何も待っていないときは、上限より大きな内容でも受け付ける)
+            can_submit_.wait(lock, [&] { return failed_ || pending_bytes_ == 0 || pending_bytes_ + size <= max_pending_bytes_; });
+            if (!failed_) pending_bytes_ += size;
+        }
+        if (!queue_.push(Request{std::move(target), std::move(contents), binary, std::move(description)})) {
+            rethrowIfFailed();
+        }
+        rethrowIfFailed();
+    }
+
+    /**
+     * @brief 依頼を締め切り、すべて書き終えるまで待ちます。
+     */
+    void finish() {
+        queue_.close();
+        if (thread_.joinable()) thread_.join();
+        flushLog();
+        rethrowIfFailed();
+    }
+
+private:
+    struct Request {
+        std::string target;
+        std::string contents;
+        bool binary = false;
+        std::string description;
+    };
+
+    void run() {
+        Request request;
+        try {
+            while (queue_.pop(request)) {
+                if (bundle_) {
+                    bundle_->add(request.target, request.contents);
+                } else {
+                    std::ostringstream log;
+                    exportWithWriter(request.target, request.binary, request.description, log,
+                                     [&](BufferedFileWriter& out) { out.put(request.contents); });
+                    appendLog(log.str());
+                }
+                {
+                    std::lock_guard<std::mutex> lock(pending_mutex_);
+                    pending_bytes_ -= request.contents.size();
+                }
+                can_submit_.notify_all();
+            }
+        } catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(pending_mutex_);
+                if (!error_) error_ = std::current_exception();
+                failed_ = true;
+            }
+            queue_.abort();
+            can_submit_.notify_all();
+        }
+    }
+
+    void wakeSubmitters() {
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            failed_ = true;
+        }
+        can_submit_.notify_all();
+    }
+
+    void rethrowIfFailed() {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        if (error_) std::rethrow_exception(error_);
+    }
+
+    void appendLog(const std::string& text) {
+        std::lock_guard<std::mutex> lock(log_mutex_);
+        pending_log_ += text;
+    }
+
+    void flushLog() {
+        std::string text;
+        {
+            std::lock_guard<std::mutex> lock(log_mutex_);
+            text.swap(pending_log_);
+        }
+        log_stream_ << text;
+    }
+
+    std::ostream& log_stream_;
+    ResultBundleWriter* bundle_;
+    const size_t max_pending_bytes_;
+    BoundedQueue<Request> queue_;
+    std::thread thread_;
+
+    std::mutex pending_mutex_;
+    std::condition_variable can_submit_;
+    size_t pending_bytes_ = 0;
+    bool failed_ = false;
+    std::exception_ptr error_;
+
+    std::mutex log_mutex_;
+    std::string pending_log_;
+};
+
+#endif // ASYNC_WRITER_HPP
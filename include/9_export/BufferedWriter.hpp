@@ -0,0 +1,151 @@
+#ifndef BUFFERED_WRITER_HPP
+#define BUFFERED_WRITER_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <charconv>
+
+/**
+ * @brief 大きなバッファに書式化してからまとめて書き出すファイルライタ
+ * 数値は std::to_chars で書式化し (ロケールに依存せず、iostream の printf 相当の書式と同じ文字列になる)、
+ * バッファが一杯になったときと close() のときだけ fwrite を呼びます。
+ * 書き込みの失敗は close() の戻り値でまとめて報告します。
+ * 書き出し先には文字列も指定できます (メモリ上で書式化して、あとでまとめて保存する場合)。
+ */
+class BufferedFileWriter {
+public:
+    static constexpr size_t kDefaultBufferSize = 1 << 20;
+
+    explicit BufferedFileWriter(const std::string& filename, bool binary = false, size_t buffer_size = kDefaultBufferSize)
+        : buffer_(buffer_size < 64 ? 64 : buffer_size) {
+        file_ = std::fopen(filename.c_str(), binary ? "wb" : "w");
+        if (file_) std::setvbuf(file_, nullptr, _IONBF, 0); // バッファリングはこちらで行う
+    }
+
+    // 書き出し先を文字列にする (*target の末尾に追記)
+    explicit BufferedFileWriter(std::string* target, size_t buffer_size = kDefaultBufferSize / 16)
+        : buffer_(buffer_size < 64 ? 64 : buffer_size), target_(target) {}
+
+    ~BufferedFileWriter() { close(); }
+
+    BufferedFileWriter(const BufferedFileWriter&) = delete;
+    BufferedFileWriter& operator=(const BufferedFileWriter&) = delete;
+
+    bool isOpen() const { return file_ != nullptr || target_ != nullptr; }
+
+    void put(char ch) {
+        if (used_ == buffer_.size()) flush();
+        buffer_[used_++] = ch;
+    }
+
+    void put(std::string_view text) {
+        if (text.size() > buffer_.size() - used_) {
+            flush();
+            if (text.size() > buffer_.size()) { // バッファより大きければ直接書く
+                writeRaw(text.data(), text.size());
+                return;
+            }
+        }
+        std::memcpy(buffer_.data() + used_, text.data(), text.size());
+        used_ += text.size();
+    }
+
+    void putBytes(const void* data, size_t size) {
+        put(std::string_view(static_cast<const char*>(data), size));
+    }
+
+    // 整数 (10進)
+    void putInt(long long value) {
+        char* out = reserve(24);
+        used_ = std::to_chars(out, out + 24, value).ptr - buffer_.data();
+    }
+
+    // 固定小数点 (ofs << std::fixed << std::setprecision(precision) と同じ)
+    void putFixed(double value, int precision) {
+        char* out = reserve(kMaxNumberLength);
+        auto result = std::to_chars(out, out + kMaxNumberLength, value, std::chars_format::fixed, precision);
+        if (result.ec != std::errc()) { // 極端に大きな値 (バッファに収まらない) は printf に任せる
+            putPrintf("%.*f", precision, value);
+            return;
+        }
+        used_ = result.ptr - buffer_.data();
+    }
+
+    // 既定の書式 (ofs << value と同じ: 有効数字 6 桁の %g)
+    void putGeneral(double value) {
+        char* out = reserve(kMaxNumberLength);
+        used_ = std::to_chars(out, out + kMaxNumberLength, value, std::chars_format::general, 6).ptr - buffer_.data();
+    }
+
+    // リトルエンディアンの 4 バイト整数・浮動小数点数 (バイナリ形式用)
+    void putU32LE(uint32_t value) {
+        char* out = reserve(4);
+        for (int i = 0; i < 4; ++i) out[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+        used_ += 4;
+    }
+    void putI32LE(int32_t value) { putU32LE(static_cast<uint32_t>(value)); }
+    void putF32LE(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        putU32LE(bits);
+    }
+
+    /**
+     * @brief バッファの中身を書き出します。
+     */
+    void flush() {
+        if (used_ > 0) writeRaw(buffer_.data(), used_);
+        used_ = 0;
+    }
+
+    /**
+     * @brief 残りを書き出してファイルを閉じます。すべての書き込みが成功していれば true を返します。
+     */
+    bool close() {
+        if (!isOpen()) return false;
+        flush();
+        if (file_ && std::fclose(file_) != 0) failed_ = true;
+        file_ = nullptr;
+        target_ = nullptr;
+        return !failed_;
+    }
+
+private:
+    static constexpr size_t kMaxNumberLength = 64;
+
+    // 少なくとも size バイトの空きを用意し、書き込み位置を返す
+    char* reserve(size_t size) {
+        if (size > buffer_.size() - used_) flush();
+        return buffer_.data() + used_;
+    }
+
+    template <typename... Args>
+    void putPrintf(const char* format, Args... args) {
+        int length = std::snprintf(nullptr, 0, format, args...);
+        if (length < 0) { failed_ = true; return; }
+        std::string text(static_cast<size_t>(length) + 1, '\0');
+        std::snprintf(text.data(), text.size(), format, args...);
+        text.pop_back();
+        put(text);
+    }
+
+    void writeRaw(const char* data, size_t size) {
+        if (target_) {
+            target_->append(data, size);
+        } else if (!file_ || std::fwrite(data, 1, size, file_) != size) {
+            failed_ = true;
+        }
+    }
+
+    std::FILE* file_ = nullptr;
+    std::vector<char> buffer_;
+    std::string* target_ = nullptr;
+    size_t used_ = 0;
+    bool failed_ = false;
+};
+
+#endif // BUFFERED_WRITER_HPP
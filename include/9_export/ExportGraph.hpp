@@ -8,9 +8,13 @@
 #include <set>
 #include <iomanip> 
 #include <ostream> // <-- 【追加】
+#include <functional>
+#include <algorithm>
 
 #include "1_core_graph/MakeBaseGraph.hpp"
+#include "1_core_graph/Logging.hpp"
 #include "3_geometry/ObjTypes.hpp" 
+#include "9_export/BufferedWriter.hpp"
 
 /**
  * @brief 頂点名 "ID_TYPE" を "TYPE_ID" 形式に変換します。
@@ -25,85 +29,180 @@ inline std::string remapVertexName(const std::string& original_name) {
     return type + "_" + core_id; // TYPE_ID 形式で結合
 }
 
+/**
+ * @brief filename を開いて write で書式化した内容を書き出し、結果を log_stream に記録します。
+ * (各 export 関数の共通部分: 開けない・書けない場合はエラーを記録して false を返す)
+ */
+inline bool exportWithWriter(
+    const std::string& filename,
+    bool binary,
+    const std::string& description,
+    std::ostream& log_stream,
+    const std::function<void(BufferedFileWriter&)>& write
+) {
+    BufferedFileWriter out(filename, binary);
+    if (!out.isOpen()) {
+        GR_LOG(log_stream, LogLevel::Error, LogSubsystem::Export, "Error: Cannot open file " << filename << '\n');
+        return false;
+    }
+    write(out);
+    if (!out.close()) {
+        GR_LOG(log_stream, LogLevel::Error, LogSubsystem::Export, "Error: Failed to write file " << filename << '\n');
+        return false;
+    }
+    GR_LOG(log_stream, LogLevel::Info, LogSubsystem::Export, description << " was written to " << filename << '\n');
+    return true;
+}
+
 // --- ▼ 【修正】 全ての関数に std::ostream& log_stream を追加 ▼ ---
 
 /**
  * @brief 【コア骨格用】コアの配置点とコア間接続をRhino用ファイルに出力します。
  */
 inline void exportCoreConnectivityForRhino(const GraphData& data, const std::string& filename, std::ostream& log_stream) {
-    std::ofstream ofs(filename);
-    if (!ofs) {
-        log_stream << "Error: Cannot open file " << filename << std::endl;
+    BufferedFileWriter out(filename);
+    if (!out.isOpen()) {
+        GR_LOG(log_stream, LogLevel::Error, LogSubsystem::Export, "Error: Cannot open file " << filename << '\n');
         return;
     }
-    std::map<int, int> core_id_to_index;
-    int current_index = 0;
-    for (const auto& pair : data.core_locations) {
-        int core_id = pair.first;
-        const Point3D& coord = pair.second;
-        ofs << coord.x << " " << coord.y << " " << coord.z << std::endl; 
-        core_id_to_index[core_id] = current_index++;
+    // (コアIDは 0 からの連番なので、コアIDがそのまま出力時の行番号になる)
+    for (const Point3D& coord : data.core_locations) {
+        out.putGeneral(coord.x);
+        out.put(' ');
+        out.putGeneral(coord.y);
+        out.put(' ');
+        out.putGeneral(coord.z);
+        out.put('\n');
     }
-    ofs << "---EDGES---" << std::endl;
+    out.put("---EDGES---\n");
     for (const auto& connection : data.core_connectivity) {
-        int id1 = connection.first;
-        int id2 = connection.second;
-        ofs << core_id_to_index.at(id1) << " " << core_id_to_index.at(id2) << std::endl;
+        out.putInt(connection.first);
+        out.put(' ');
+        out.putInt(connection.second);
+        out.put('\n');
+    }
+    if (!out.close()) {
+        GR_LOG(log_stream, LogLevel::Error, LogSubsystem::Export, "Error: Failed to write file " << filename << '\n');
+        return;
     }
-    log_stream << "Core connectivity data for Rhino was written to " << filename << std::endl;
+    GR_LOG(log_stream, LogLevel::Info, LogSubsystem::Export, "Core connectivity data for Rhino was written to " << filename << '\n');
 }
 
 /**
- * @brief 【内容確認用】全体の詳細なグラフを.dot形式でファイルに出力します。
+ * @brief グラフを .dot 形式で out に書式化します (exportFullGraphForChecking の中身)。
  */
-inline void exportFullGraphForChecking(const tdzdd::Graph& graph, const std::string& filename, std::ostream& log_stream) {
-    std::ofstream ofs(filename);
-    if (!ofs) {
-        log_stream << "Error: Cannot open file " << filename << std::endl;
-        return;
-    }
-    ofs << "graph G {" << std::endl;
-    ofs << "  node [shape=circle];" << std::endl;
-    for (int i = 0; i < graph.edgeSize(); ++i) {
-        const auto& edge = graph.edgeInfo(i);
-        std::string v1_name_original = graph.vertexName(edge.v1);
-        std::string v2_name_original = graph.vertexName(edge.v2);
-        
-        std::string v1_name_remapped = remapVertexName(v1_name_original);
-        std::string v2_name_remapped = remapVertexName(v2_name_original);
-
-        ofs << "  \"" << v1_name_remapped << "\" -- \"" << v2_name_remapped << "\";" << std::endl;
+inline void writeGraphDot(
+    const IntGraph& graph,
+    BufferedFileWriter& out,
+    const std::function<std::string(int)>& vertex_name = integerVertexName
+) {
+    out.put("graph G {\n");
+    out.put("  node [shape=circle];\n");
+    for (const auto& edge : graph.edges) {
+        out.put("  \"");
+        out.put(remapVertexName(vertex_name(edge.first)));
+        out.put("\" -- \"");
+        out.put(remapVertexName(vertex_name(edge.second)));
+        out.put("\";\n");
     }
-    ofs << "}" << std::endl;
-    log_stream << "Full graph data for checking was written to " << filename << std::endl;
+    out.put("}\n");
 }
 
 /**
- * @brief ObjMesh 構造体を .obj ファイルとして書き出します (デバッグ用)
+ * @brief 【内容確認用】全体の詳細なグラフを.dot形式でファイルに出力します。
+ * 頂点名は vertex_name で出力時にだけ生成します (既定は頂点IDの10進表記)。
  */
-inline void exportObjMesh(const ObjMesh& mesh, const std::string& filename, std::ostream& log_stream) {
-    std::ofstream ofs(filename);
-    if (!ofs) {
-        log_stream << "Error: Cannot open file " << filename << std::endl;
-        return;
+inline void exportFullGraphForChecking(
+    const IntGraph& graph,
+    const std::string& filename,
+    std::ostream& log_stream,
+    const std::function<std::string(int)>& vertex_name = integerVertexName
+) {
+    exportWithWriter(filename, false, "Full graph data for checking", log_stream, [&](BufferedFileWriter& out) { writeGraphDot(graph, out, vertex_name); });
+}
+
+/**
+ * @brief メッシュを OBJ 形式で out に書式化します (exportObjMesh の中身)。
+ */
+inline void writeObjMesh(const PackedMesh& mesh, BufferedFileWriter& out) {
+    out.put("# --- Vertices (");
+    out.putInt(mesh.vertexSize());
+    out.put(") ---\n");
+    for (int v = 0; v < mesh.vertexSize(); ++v) {
+        out.put("v ");
+        out.putFixed(mesh.xs[v], 3);
+        out.put(' ');
+        out.putFixed(mesh.ys[v], 3);
+        out.put(' ');
+        out.putFixed(mesh.zs[v], 3);
+        out.put('\n');
     }
 
-    ofs << "# --- Vertices (" << mesh.vertices.size() << ") ---" << std::endl;
-    for (const auto& v : mesh.vertices) {
-        ofs << "v " << std::fixed << std::setprecision(3) 
-            << v.x << " " << v.y << " " << v.z << std::endl;
+    out.put("\n# --- Faces (");
+    out.putInt(mesh.faceSize());
+    out.put(") ---\n");
+    for (int f = 0; f < mesh.faceSize(); ++f) {
+        out.put('f');
+        for (int idx : mesh.face(f)) {
+            out.put(' ');
+            out.putInt(idx + 1); // 0-based -> 1-based
+        }
+        out.put('\n');
     }
+}
+
+/**
+ * @brief メッシュを .obj ファイルとして書き出します (デバッグ用)
+ * 出力は rhino_scripts/ObjToRhino.py が読む従来の書式 (座標は小数点以下 3 桁) のままです。
+ */
+inline void exportObjMesh(const PackedMesh& mesh, const std::string& filename, std::ostream& log_stream) {
+    exportWithWriter(filename, false, "Debug mesh data", log_stream, [&](BufferedFileWriter& out) { writeObjMesh(mesh, out); });
+}
+
+/**
+ * @brief メッシュをバイナリ PLY 形式で out に書式化します (exportPlyMesh の中身)。
+ */
+inline void writePlyMesh(const PackedMesh& mesh, BufferedFileWriter& out) {
+    int max_face_size = 0;
+    for (int f = 0; f < mesh.faceSize(); ++f) max_face_size = std::max(max_face_size, mesh.face(f).size());
+    const bool short_lists = (max_face_size <= 255); // 面の頂点数を uchar で書けるか
 
-    ofs << "\n# --- Faces (" << mesh.faces.size() << ") ---" << std::endl;
-    for (const auto& face : mesh.faces) {
-        ofs << "f";
-        for (int idx : face) {
-            ofs << " " << (idx + 1); // 0-based -> 1-based
+    out.put("ply\nformat binary_little_endian 1.0\n");
+    out.put("element vertex ");
+    out.putInt(mesh.vertexSize());
+    out.put("\nproperty float x\nproperty float y\nproperty float z\n");
+    out.put("element face ");
+    out.putInt(mesh.faceSize());
+    out.put(short_lists ? "\nproperty list uchar int vertex_indices\n" : "\nproperty list int int vertex_indices\n");
+    out.put("end_header\n");
+
+    for (int v = 0; v < mesh.vertexSize(); ++v) {
+        out.putF32LE(static_cast<float>(mesh.xs[v]));
+        out.putF32LE(static_cast<float>(mesh.ys[v]));
+        out.putF32LE(static_cast<float>(mesh.zs[v]));
+    }
+    for (int f = 0; f < mesh.faceSize(); ++f) {
+        FaceRange face = mesh.face(f);
+        if (short_lists) {
+            out.put(static_cast<char>(face.size()));
+        } else {
+            out.putI32LE(static_cast<int32_t>(face.size()));
         }
-        ofs << std::endl;
+        for (int idx : face) out.putI32LE(idx);
     }
-    
-    log_stream << "Debug mesh data was written to " << filename << std::endl;
+}
+
+/**
+ * @brief メッシュをバイナリ PLY (binary_little_endian 1.0) として書き出します。
+ * 座標は float、面は頂点番号 (0-based) のリストです。OBJ より小さく、読み込みも速い形式です。
+ */
+inline void exportPlyMesh(const PackedMesh& mesh, const std::string& filename, std::ostream& log_stream) {
+    exportWithWriter(filename, true, "Binary PLY mesh", log_stream, [&](BufferedFileWriter& out) { writePlyMesh(mesh, out); });
+}
+
+// アダプタ: ローダー形式の ObjMesh をそのまま書き出す
+inline void exportObjMesh(const ObjMesh& mesh, const std::string& filename, std::ostream& log_stream) {
+    exportObjMesh(packMesh(mesh), filename, log_stream);
 }
 // --- ▲ 【修正】 ▲ ---
 
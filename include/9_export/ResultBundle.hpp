@@ -0,0 +1,214 @@
+#ifndef RESULT_BUNDLE_HPP
+#define RESULT_BUNDLE_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <filesystem>
+
+#include "1_core_graph/MappedFile.hpp"
+
+// --- 結果バンドル (出力ファイルを1つにまとめたコンテナ) ---
+// 書式 (数値はすべてリトルエンディアン):
+//   ヘッダ (32 バイト): マジック "GRBUNDLE", 版数 u32, 予約 u32, 索引の位置 u64, エントリ数 u64
+//   本体:   各エントリの中身 (追加した順に隙間なく並ぶ)
+//   索引:   エントリごとに 位置 u64, バイト数 u64, 名前のバイト数 u32, 名前
+// 中身は追加のたびに末尾へ順に書き、索引は close() のときに末尾へ書いてからヘッダをその位置に書き換えます。
+// 既存のバンドルへの追記も同じ手順で、古い索引の後ろに続けて書きます
+// (途中で失敗してもヘッダは古い索引を指したままなので、それまでのエントリは読めます)。
+// 同じ名前のエントリが複数あれば、名前で引いたときは後から追加したものが有効です。
+
+constexpr char kResultBundleMagic[8] = {'G', 'R', 'B', 'U', 'N', 'D', 'L', 'E'};
+constexpr uint32_t kResultBundleVersion = 1;
+constexpr size_t kResultBundleHeaderSize = 32;
+
+// ヘルパー: リトルエンディアンの整数の読み書き
+inline void appendLittleEndian(std::string& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+inline uint64_t readLittleEndian(const char* data, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) value |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+    return value;
+}
+
+/**
+ * @brief バンドル内のエントリ (名前は読み込んだバンドルのメモリを指す)
+ */
+struct ResultBundleEntry {
+    std::string_view name;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+};
+
+/**
+ * @brief 結果バンドルの読み込み (メモリにマップし、索引から任意のエントリを直接参照する)
+ * 構築時にヘッダと索引を検査し、壊れていれば例外を投げます。
+ */
+class ResultBundleReader {
+public:
+    explicit ResultBundleReader(const std::string& filename) : file_(filename) {
+        const char* data = file_.data();
+        const uint64_t size = file_.size();
+        if (size < kResultBundleHeaderSize || std::memcmp(data, kResultBundleMagic, sizeof(kResultBundleMagic)) != 0) {
+            throw std::runtime_error("Error: Not a result bundle: " + filename);
+        }
+        uint32_t version = static_cast<uint32_t>(readLittleEndian(data + 8, 4));
+        if (version != kResultBundleVersion) {
+            throw std::runtime_error("Error: Result bundle " + filename + " has format version " + std::to_string(version) +
+                                     " (expected " + std::to_string(kResultBundleVersion) + ")");
+        }
+        index_offset_ = readLittleEndian(data + 16, 8);
+        const uint64_t count = readLittleEndian(data + 24, 8);
+        auto corrupt = [&]() { return std::runtime_error("Error: Corrupt result bundle: " + filename); };
+        if (index_offset_ < kResultBundleHeaderSize || index_offset_ > size) throw corrupt();
+
+        uint64_t pos = index_offset_;
+        for (uint64_t i = 0; i < count; ++i) {
+            if (size - pos < 20) throw corrupt();
+            ResultBundleEntry entry;
+            entry.offset = readLittleEndian(data + pos, 8);
+            entry.size = readLittleEndian(data + pos + 8, 8);
+            uint64_t name_size = readLittleEndian(data + pos + 16, 4);
+            pos += 20;
+            if (size - pos < name_size) throw corrupt();
+            if (entry.offset < kResultBundleHeaderSize || entry.offset > index_offset_ ||
+                entry.size > index_offset_ - entry.offset) throw corrupt();
+            entry.name = std::string_view(data + pos, name_size);
+            pos += name_size;
+            by_name_[entry.name] = static_cast<int>(entries_.size()); // (同名なら後から追加したエントリ)
+            entries_.push_back(entry);
+        }
+    }
+
+    size_t entryCount() const { return entries_.size(); }
+    const std::vector<ResultBundleEntry>& entries() const { return entries_; }
+    uint64_t indexOffset() const { return index_offset_; }
+
+    /**
+     * @brief i 番目のエントリの中身 (コピーせずにマップしたメモリを指す)
+     */
+    std::string_view data(size_t i) const {
+        const ResultBundleEntry& entry = entries_.at(i);
+        return std::string_view(file_.data() + entry.offset, entry.size);
+    }
+
+    /**
+     * @brief 名前からエントリ番号を引きます (無ければ -1, 同名が複数あれば最後のもの)
+     */
+    int find(std::string_view name) const {
+        auto it = by_name_.find(name);
+        return it == by_name_.end() ? -1 : it->second;
+    }
+
+private:
+    MappedFile file_;
+    uint64_t index_offset_ = 0;
+    std::vector<ResultBundleEntry> entries_;
+    std::unordered_map<std::string_view, int> by_name_;
+};
+
+/**
+ * @brief 結果バンドルの書き出し (エントリを順に追記し、close() で索引を書く)
+ * append が true で既存のバンドルがあれば、そのエントリを残したまま追記します。
+ * 失敗は例外で報告します (デストラクタでは例外を投げず、索引を書けなければ古いヘッダのまま残ります)。
+ */
+class ResultBundleWriter {
+public:
+    explicit ResultBundleWriter(const std::string& filename, bool append = false) : filename_(filename) {
+        if (append && std::filesystem::exists(filename)) {
+            {
+                ResultBundleReader existing(filename);
+                for (const ResultBundleEntry& entry : existing.entries()) {
+                    entries_.push_back({std::string(entry.name), entry.offset, entry.size});
+                }
+            }
+            file_ = std::fopen(filename.c_str(), "r+b");
+            if (!file_ || std::fseek(file_, 0, SEEK_END) != 0) {
+                throw std::runtime_error("Error: Cannot open result bundle for appending: " + filename);
+            }
+            write_pos_ = static_cast<uint64_t>(std::ftell(file_));
+        } else {
+            file_ = std::fopen(filename.c_str(), "wb");
+            // (索引の位置は close() で書き換える。それまでは空のバンドルとして読める)
+            if (!file_ || !writeHeader(kResultBundleHeaderSize, 0)) {
+                throw std::runtime_error("Error: Cannot open result bundle for writing: " + filename);
+            }
+            write_pos_ = kResultBundleHeaderSize;
+        }
+    }
+
+    ~ResultBundleWriter() {
+        try {
+            close();
+        } catch (const std::exception&) {
+            // (デストラクタからは投げない)
+        }
+    }
+
+    ResultBundleWriter(const ResultBundleWriter&) = delete;
+    ResultBundleWriter& operator=(const ResultBundleWriter&) = delete;
+
+    /**
+     * @brief エントリを1つ末尾に追加します。
+     */
+    void add(const std::string& name, std::string_view data) {
+        if (!file_) throw std::logic_error("ResultBundleWriter::add: the bundle is already closed");
+        if (!data.empty() && std::fwrite(data.data(), 1, data.size(), file_) != data.size()) {
+            throw std::runtime_error("Error: Failed to write result bundle: " + filename_);
+        }
+        entries_.push_back({name, write_pos_, data.size()});
+        write_pos_ += data.size();
+    }
+
+    size_t entryCount() const { return entries_.size(); }
+
+    /**
+     * @brief 索引を書き、ヘッダを新しい索引に向けてファイルを閉じます。
+     */
+    void close() {
+        if (!file_) return;
+        std::string index;
+        for (const Entry& entry : entries_) {
+            appendLittleEndian(index, entry.offset, 8);
+            appendLittleEndian(index, entry.size, 8);
+            appendLittleEndian(index, entry.name.size(), 4);
+            index += entry.name;
+        }
+        bool ok = std::fwrite(index.data(), 1, index.size(), file_) == index.size() &&
+                  std::fflush(file_) == 0 &&
+                  std::fseek(file_, 0, SEEK_SET) == 0;
+        ok = ok && writeHeader(write_pos_, entries_.size());
+        ok = (std::fclose(file_) == 0) && ok;
+        file_ = nullptr;
+        if (!ok) throw std::runtime_error("Error: Failed to write result bundle index: " + filename_);
+    }
+
+private:
+    struct Entry {
+        std::string name;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    bool writeHeader(uint64_t index_offset, uint64_t count) {
+        std::string header(kResultBundleMagic, sizeof(kResultBundleMagic));
+        appendLittleEndian(header, kResultBundleVersion, 4);
+        appendLittleEndian(header, 0, 4);
+        appendLittleEndian(header, index_offset, 8);
+        appendLittleEndian(header, count, 8);
+        return std::fwrite(header.data(), 1, header.size(), file_) == header.size();
+    }
+
+    std::string filename_;
+    std::FILE* file_ = nullptr;
+    uint64_t write_pos_ = 0;
+    std::vector<Entry> entries_;
+};
+
+#endif // RESULT_BUNDLE_HPP
@@ -0,0 +1,665 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <chrono>
+#include <sstream>
+#include <fstream>
+#include <exception>
+#include <algorithm>
+#include <iomanip>
+#include <filesystem>
+
+// --- 必要なプロジェクトヘッダ ---
+#include "1_core_graph/GraphLoader.hpp"
+#include "1_core_graph/DefinitionCache.hpp"
+#include "1_core_graph/Logging.hpp"
+#include "2_search/ConstrainedSearch.hpp"
+#include "3_geometry/PreparedTemplates.hpp"
+#include "3_geometry/CoincidentFaces.hpp"
+#include "3_geometry/SolutionMesh.hpp"
+#include "3_geometry/DualGraph.hpp"
+#include "3_geometry/IncrementalGeometry.hpp"
+#include "4_analysis/GraphIsomorphism.hpp"
+#include "9_export/ExportGraph.hpp"
+#include "9_export/AsyncWriter.hpp"
+
+// --- マイクロベンチマーク ---
+// 使い方: bench [--repeat R] <definition_file.txt> ...
+// (引数が無ければ graph_definitions/ の同梱ファイルすべてを対象にする)
+
+using BenchClock = std::chrono::steady_clock;
+
+// ヘルパー: 経過時間 (ミリ秒)
+inline double elapsedMs(BenchClock::time_point start) {
+    return std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+}
+
+// 比較用: 以前の接合面検出 (std::set<GridPoint3D> をキーとする std::map と std::set<int>)
+int legacyMarkCoincidentFaces(
+    const PackedMesh& mesh,
+    const std::vector<GridPoint3D>& grid_vertices,
+    std::vector<bool>& to_delete
+) {
+    std::map<std::set<GridPoint3D>, std::vector<int>> face_map;
+    for (int i = 0; i < mesh.faceSize(); ++i) {
+        std::set<GridPoint3D> key;
+        for (int idx : mesh.face(i)) key.insert(grid_vertices[idx]);
+        face_map[key].push_back(i);
+    }
+    std::set<int> faces_to_delete;
+    for (const auto& pair : face_map) {
+        if (pair.second.size() > 1) faces_to_delete.insert(pair.second.begin(), pair.second.end());
+    }
+    to_delete.assign(mesh.faceSize(), false);
+    for (int f : faces_to_delete) to_delete[f] = true;
+    return static_cast<int>(faces_to_delete.size());
+}
+
+// 比較用: 以前の定義ファイル読み込み (std::getline と行ごとの std::stringstream)
+void legacyParseDefinitions(
+    std::istream& file,
+    CoreGraph& core_graph,
+    std::vector<ConnectionRule>& rules,
+    std::map<std::string, ObjMesh>& mesh_data
+) {
+    core_graph = CoreGraph();
+    rules.clear();
+    mesh_data.clear();
+
+    std::string line, keyword;
+    ParseState state = ParseState::None;
+    ConnectionRule current_rule;
+    bool in_rule = false;
+    std::string current_mesh_type = "";
+
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::stringstream ss(line);
+        ss >> keyword;
+
+        if (keyword == "CORE_GRAPH") {
+            state = ParseState::ReadingCore;
+            current_mesh_type = "";
+            continue;
+        } else if (keyword == "RULES") {
+            state = ParseState::ReadingRules;
+            current_mesh_type = "";
+            continue;
+        } else if (keyword == "VERTEX_MESH") {
+            state = ParseState::ReadingMesh;
+            ss >> current_mesh_type;
+            if (!current_mesh_type.empty()) mesh_data[current_mesh_type] = ObjMesh();
+            continue;
+        }
+
+        switch (state) {
+            case ParseState::ReadingCore: {
+                std::string v2;
+                ss >> v2;
+                if (!v2.empty()) core_graph.addEdge(keyword, v2);
+                break;
+            }
+            case ParseState::ReadingRules: {
+                if (keyword == "RULE") {
+                    if (in_rule) rules.push_back(current_rule);
+                    current_rule = ConnectionRule();
+                    in_rule = true;
+                } else if (keyword == "VECTOR") {
+                    ss >> current_rule.vector.x >> current_rule.vector.y >> current_rule.vector.z;
+                } else if (keyword == "CONNECT") {
+                    std::string v1, v2;
+                    ss >> v1 >> v2;
+                    current_rule.connections.push_back({v1, v2});
+                }
+                break;
+            }
+            case ParseState::ReadingMesh: {
+                if (current_mesh_type.empty()) break;
+                ObjMesh& current_mesh = mesh_data.at(current_mesh_type);
+                if (keyword == "v") {
+                    Point3D p;
+                    ss >> p.x >> p.y >> p.z;
+                    current_mesh.vertices.push_back(p);
+                } else if (keyword == "f") {
+                    std::vector<int> face_indices;
+                    int idx;
+                    while (ss >> idx) face_indices.push_back(idx - 1);
+                    if (face_indices.size() >= 3) current_mesh.faces.push_back(face_indices);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    if (in_rule) rules.push_back(current_rule);
+    core_graph.update();
+}
+
+// 読み込み結果一式
+struct LoadedDefinitions {
+    CoreGraph core_graph;
+    std::vector<ConnectionRule> rules;
+    std::map<std::string, ObjMesh> mesh_data;
+};
+
+// ヘルパー: 2つの読み込み結果が完全に一致するか
+bool sameDefinitions(const LoadedDefinitions& a, const LoadedDefinitions& b) {
+    auto samePoint = [](const Point3D& p, const Point3D& q) { return p.x == q.x && p.y == q.y && p.z == q.z; };
+    if (a.core_graph.vertexSize() != b.core_graph.vertexSize() || a.core_graph.edgeSize() != b.core_graph.edgeSize()) return false;
+    for (int e = 0; e < a.core_graph.edgeSize(); ++e) {
+        const auto& ea = a.core_graph.edgeInfo(e);
+        const auto& eb = b.core_graph.edgeInfo(e);
+        if (a.core_graph.vertexName(ea.v1) != b.core_graph.vertexName(eb.v1) ||
+            a.core_graph.vertexName(ea.v2) != b.core_graph.vertexName(eb.v2)) return false;
+    }
+    if (a.rules.size() != b.rules.size()) return false;
+    for (size_t i = 0; i < a.rules.size(); ++i) {
+        if (!samePoint(a.rules[i].vector, b.rules[i].vector) || a.rules[i].connections != b.rules[i].connections) return false;
+    }
+    if (a.mesh_data.size() != b.mesh_data.size()) return false;
+    for (auto it = a.mesh_data.begin(), jt = b.mesh_data.begin(); it != a.mesh_data.end(); ++it, ++jt) {
+        if (it->first != jt->first || it->second.faces != jt->second.faces) return false;
+        if (it->second.vertices.size() != jt->second.vertices.size()) return false;
+        for (size_t v = 0; v < it->second.vertices.size(); ++v) {
+            if (!samePoint(it->second.vertices[v], jt->second.vertices[v])) return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 定義ファイルの読み込み: 同じ内容 (メモリ上) を旧実装と新実装で繰り返し読み、スループットを比べます。
+ * ファイル I/O の時間は含みません。
+ */
+void benchParseDefinitions(const std::string& label, const std::string& contents, int repeat) {
+    LoadedDefinitions expected, actual;
+    std::istringstream first_pass(contents);
+    legacyParseDefinitions(first_pass, expected.core_graph, expected.rules, expected.mesh_data);
+    parseDefinitions(contents.data(), contents.size(), label, actual.core_graph, actual.rules, actual.mesh_data);
+    if (!sameDefinitions(expected, actual)) {
+        std::cout << label << ": MISMATCH between legacy and streaming definition parsers!" << std::endl;
+        return;
+    }
+
+    LoadedDefinitions scratch;
+    auto start = BenchClock::now();
+    for (int r = 0; r < repeat; ++r) {
+        std::istringstream in(contents);
+        legacyParseDefinitions(in, scratch.core_graph, scratch.rules, scratch.mesh_data);
+    }
+    double legacy_ms = elapsedMs(start);
+    start = BenchClock::now();
+    for (int r = 0; r < repeat; ++r) {
+        parseDefinitions(contents.data(), contents.size(), label, scratch.core_graph, scratch.rules, scratch.mesh_data);
+    }
+    double streaming_ms = elapsedMs(start);
+
+    double megabytes = static_cast<double>(contents.size()) * repeat / (1024.0 * 1024.0);
+    std::cout << label << ": definition parsing, " << contents.size() << " bytes x " << repeat << " repeats" << std::endl;
+    std::cout << "  legacy (getline/stringstream): " << legacy_ms << " ms (" << (legacy_ms > 0 ? megabytes * 1000.0 / legacy_ms : 0.0) << " MB/s)" << std::endl;
+    std::cout << "  streaming (from_chars):        " << streaming_ms << " ms (" << (streaming_ms > 0 ? megabytes * 1000.0 / streaming_ms : 0.0) << " MB/s)" << std::endl;
+    std::cout << "  speedup: " << (streaming_ms > 0 ? legacy_ms / streaming_ms : 0.0) << "x" << std::endl;
+}
+
+/**
+ * @brief 起動時の読み込み: テキストの解析と格子生成 (loadDefinitions + make_base_graph) と、
+ * コンパイル済みキャッシュの読み込み (マップ + 元ファイルとの照合 + 組み立て) の時間を比べます。
+ */
+void benchDefinitionCache(const std::string& definition_file, int repeat) {
+    std::ostringstream discarded_log;
+    std::string cache_file = (std::filesystem::temp_directory_path() /
+                              ("bench_" + std::filesystem::path(definition_file).stem().string() + ".cache")).string();
+    compileDefinitionCache(definition_file, cache_file, discarded_log);
+
+    auto loadText = [&](LoadedDefinitions& loaded, GraphData& base_data) {
+        loadDefinitions(definition_file, loaded.core_graph, loaded.rules, loaded.mesh_data);
+        base_data = make_base_graph(loaded.core_graph, loaded.rules, defaultLatticeDepth(loaded.core_graph),
+                                    discarded_log, BaseGraphOptions{false});
+    };
+    auto loadCached = [&](LoadedDefinitions& loaded, GraphData& base_data) {
+        CompiledDefinitions cache(cache_file);
+        MappedFile source(definition_file);
+        if (!cache.matchesSource(source.data(), source.size())) throw std::runtime_error("stale cache");
+        cache.materializeDefinitions(loaded.core_graph, loaded.rules, loaded.mesh_data);
+        base_data = cache.materializeBaseGraph();
+    };
+
+    // 結果が一致することを確認
+    LoadedDefinitions expected, actual;
+    GraphData expected_graph, actual_graph;
+    loadText(expected, expected_graph);
+    loadCached(actual, actual_graph);
+    auto sameLocations = [](const std::vector<Point3D>& a, const std::vector<Point3D>& b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (a[i].x != b[i].x || a[i].y != b[i].y || a[i].z != b[i].z) return false;
+        }
+        return true;
+    };
+    if (!sameDefinitions(expected, actual) || expected_graph.vertex_types != actual_graph.vertex_types ||
+        !sameLocations(expected_graph.core_locations, actual_graph.core_locations) ||
+        expected_graph.core_connectivity != actual_graph.core_connectivity ||
+        expected_graph.full_graph.edges != actual_graph.full_graph.edges ||
+        expected_graph.full_graph.id_bound != actual_graph.full_graph.id_bound ||
+        expected_graph.full_graph.num_vertices != actual_graph.full_graph.num_vertices) {
+        std::cout << definition_file << ": MISMATCH between parsed and cached definitions!" << std::endl;
+        std::remove(cache_file.c_str());
+        return;
+    }
+
+    LoadedDefinitions scratch;
+    GraphData scratch_graph;
+    auto start = BenchClock::now();
+    for (int r = 0; r < repeat; ++r) loadText(scratch, scratch_graph);
+    double text_ms = elapsedMs(start);
+    start = BenchClock::now();
+    for (int r = 0; r < repeat; ++r) loadCached(scratch, scratch_graph);
+    double cached_ms = elapsedMs(start);
+    std::remove(cache_file.c_str());
+
+    std::cout << definition_file << ": startup, " << repeat << " repeats (" << expected_graph.core_locations.size()
+              << " cores, " << expected_graph.full_graph.edgeSize() << " edges)" << std::endl;
+    std::cout << "  parse + make_base_graph: " << text_ms * 1000.0 / repeat << " us/load" << std::endl;
+    std::cout << "  compiled cache (mmap):   " << cached_ms * 1000.0 / repeat << " us/load" << std::endl;
+    std::cout << "  speedup: " << (cached_ms > 0 ? text_ms / cached_ms : 0.0) << "x" << std::endl;
+}
+
+/**
+ * @brief ログのレベル: 格子生成と G'/G'' の構築・探索を、以前と同じ量のログ (Trace) と既定のログ (Info) で比べます。
+ */
+void benchLogging(const std::string& definition_file, int repeat) {
+    LoadedDefinitions loaded;
+    loadDefinitions(definition_file, loaded.core_graph, loaded.rules, loaded.mesh_data);
+    const int n = defaultLatticeDepth(loaded.core_graph);
+
+    auto run = [&](LogLevel level, size_t& log_bytes) {
+        setLogLevel(level);
+        log_bytes = 0;
+        auto start = BenchClock::now();
+        for (int r = 0; r < repeat; ++r) {
+            std::ostringstream log;
+            GraphData base_data = make_base_graph(loaded.core_graph, loaded.rules, n, log);
+            findAllConstrainedGraphs(base_data, loaded.core_graph, "0_a", log, [](const std::set<std::string>&) {});
+            log_bytes += log.tellp();
+        }
+        return elapsedMs(start);
+    };
+    size_t verbose_bytes = 0, default_bytes = 0;
+    double verbose_ms = run(LogLevel::Trace, verbose_bytes);
+    double default_ms = run(LogLevel::Info, default_bytes);
+    setLogLevel(LogLevel::Info);
+
+    std::cout << definition_file << ": logging, " << repeat << " repeats (make_base_graph + search)" << std::endl;
+    std::cout << "  trace: " << verbose_ms * 1000.0 / repeat << " us/run, " << verbose_bytes / repeat << " log bytes" << std::endl;
+    std::cout << "  info:  " << default_ms * 1000.0 / repeat << " us/run, " << default_bytes / repeat << " log bytes" << std::endl;
+    std::cout << "  speedup: " << (default_ms > 0 ? verbose_ms / default_ms : 0.0) << "x" << std::endl;
+}
+
+// 比較用: 以前の OBJ 書き出し (std::ofstream に1行ずつ, 行ごとに std::endl でフラッシュ)
+void legacyExportObjMesh(const PackedMesh& mesh, const std::string& filename) {
+    std::ofstream ofs(filename);
+    ofs << "# --- Vertices (" << mesh.vertexSize() << ") ---" << std::endl;
+    for (int v = 0; v < mesh.vertexSize(); ++v) {
+        ofs << "v " << std::fixed << std::setprecision(3)
+            << mesh.xs[v] << " " << mesh.ys[v] << " " << mesh.zs[v] << std::endl;
+    }
+    ofs << "\n# --- Faces (" << mesh.faceSize() << ") ---" << std::endl;
+    for (int f = 0; f < mesh.faceSize(); ++f) {
+        ofs << "f";
+        for (int idx : mesh.face(f)) ofs << " " << (idx + 1);
+        ofs << std::endl;
+    }
+}
+
+// ヘルパー: ファイルの中身
+std::string readWholeFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+/**
+ * @brief メッシュの書き出し: 以前の OBJ 書き出し、バッファ付きの OBJ 書き出し、バイナリ PLY の時間とサイズを比べます。
+ */
+void benchMeshExport(const std::string& label, const PackedMesh& mesh, int repeat) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path();
+    std::string legacy_file = (dir / "bench_legacy.obj").string();
+    std::string buffered_file = (dir / "bench_buffered.obj").string();
+    std::string ply_file = (dir / "bench_binary.ply").string();
+    std::ostringstream discarded_log;
+
+    legacyExportObjMesh(mesh, legacy_file);
+    exportObjMesh(mesh, buffered_file, discarded_log);
+    if (readWholeFile(legacy_file) != readWholeFile(buffered_file)) {
+        std::cout << label << ": MISMATCH between legacy and buffered OBJ output!" << std::endl;
+        return;
+    }
+
+    auto start = BenchClock::now();
+    for (int r = 0; r < repeat; ++r) legacyExportObjMesh(mesh, legacy_file);
+    double legacy_ms = elapsedMs(start);
+    start = BenchClock::now();
+    for (int r = 0; r < repeat; ++r) exportObjMesh(mesh, buffered_file, discarded_log);
+    double buffered_ms = elapsedMs(start);
+    start = BenchClock::now();
+    for (int r = 0; r < repeat; ++r) exportPlyMesh(mesh, ply_file, discarded_log);
+    double ply_ms = elapsedMs(start);
+
+    std::cout << label << ": mesh export, " << mesh.vertexSize() << " vertices / " << mesh.faceSize() << " faces x "
+              << repeat << " repeats" << std::endl;
+    std::cout << "  legacy OBJ (ofstream/endl): " << legacy_ms / repeat << " ms/file" << std::endl;
+    std::cout << "  buffered OBJ (to_chars):    " << buffered_ms / repeat << " ms/file (" << std::filesystem::file_size(buffered_file)
+              << " bytes, speedup " << (buffered_ms > 0 ? legacy_ms / buffered_ms : 0.0) << "x)" << std::endl;
+    std::cout << "  binary PLY:                 " << ply_ms / repeat << " ms/file (" << std::filesystem::file_size(ply_file)
+              << " bytes)" << std::endl;
+    std::remove(legacy_file.c_str());
+    std::remove(buffered_file.c_str());
+    std::remove(ply_file.c_str());
+}
+
+/**
+ * @brief 書き出しの非同期化: 同じメッシュを count 個の OBJ ファイルに書くとき、
+ * 書式化と書き込みを1スレッドで順に行う場合と、書き込みを AsyncFileWriter に任せる場合の時間を比べます。
+ * 両方の出力ディレクトリのファイルがバイト単位で一致することも確かめます。
+ */
+void benchAsyncExport(const std::string& label, const PackedMesh& mesh, int count) {
+    std::filesystem::path sync_dir = std::filesystem::temp_directory_path() / "bench_sync_export";
+    std::filesystem::path async_dir = std::filesystem::temp_directory_path() / "bench_async_export";
+    std::filesystem::remove_all(sync_dir); // (どちらも空のディレクトリに新しいファイルを作る条件で比べる)
+    std::filesystem::remove_all(async_dir);
+    std::filesystem::create_directories(sync_dir);
+    std::filesystem::create_directories(async_dir);
+    auto filename = [](const std::filesystem::path& dir, int i) {
+        return (dir / ("mesh_" + std::to_string(i) + ".obj")).string();
+    };
+    std::ostringstream discarded_log;
+
+    auto start = BenchClock::now();
+    for (int i = 0; i < count; ++i) exportObjMesh(mesh, filename(sync_dir, i), discarded_log);
+    double sync_ms = elapsedMs(start);
+
+    start = BenchClock::now();
+    {
+        AsyncFileWriter writer(discarded_log);
+        for (int i = 0; i < count; ++i) {
+            std::string contents;
+            {
+                BufferedFileWriter out(&contents);
+                writeObjMesh(mesh, out);
+            }
+            writer.submit(filename(async_dir, i), std::move(contents), false, "Debug mesh data");
+        }
+        writer.finish();
+    }
+    double async_ms = elapsedMs(start);
+
+    bool same = true;
+    for (int i = 0; i < count && same; ++i) {
+        same = readWholeFile(filename(sync_dir, i)) == readWholeFile(filename(async_dir, i));
+    }
+    size_t file_size = std::filesystem::file_size(filename(sync_dir, 0));
+    std::filesystem::remove_all(sync_dir);
+    std::filesystem::remove_all(async_dir);
+    if (!same) {
+        std::cout << label << ": MISMATCH between synchronous and background-writer OBJ output!" << std::endl;
+        return;
+    }
+
+    std::cout << label << ": exporting " << count << " OBJ files (" << file_size << " bytes each)" << std::endl;
+    std::cout << "  synchronous:          " << sync_ms << " ms" << std::endl;
+    std::cout << "  background writer:    " << async_ms << " ms (speedup " << (async_ms > 0 ? sync_ms / async_ms : 0.0) << "x)" << std::endl;
+}
+
+// ヘルパー: 大きなメッシュを含む合成の定義ファイル (side x side x side の格子点と四角形面)
+std::string syntheticDefinitions(int side) {
+    std::ostringstream out;
+    out << "# synthetic definition file for parser benchmarks\n";
+    out << "CORE_GRAPH\n0_a 1_b\n\nRULES\nRULE\nVECTOR 1.0 0.0 0.0\nCONNECT a b\n\n";
+    out << "VERTEX_MESH a\n";
+    for (int i = 0; i < side; ++i)
+        for (int j = 0; j < side; ++j)
+            for (int k = 0; k < side; ++k)
+                out << "v " << i * 0.125 << " " << j * 0.125 - 0.5 << " " << k * 0.375 << "\n";
+    auto id = [side](int i, int j, int k) { return (i * side + j) * side + k + 1; };
+    for (int i = 0; i < side; ++i)
+        for (int j = 0; j + 1 < side; ++j)
+            for (int k = 0; k + 1 < side; ++k)
+                out << "f " << id(i, j, k) << " " << id(i, j + 1, k) << " " << id(i, j + 1, k + 1) << " " << id(i, j, k + 1) << "\n";
+    return out.str();
+}
+
+// 解ごとの統合メッシュ (接合面の削除前) と量子化座標
+struct MergedMesh {
+    PackedMesh mesh;
+    std::vector<GridPoint3D> grid_vertices;
+};
+
+/**
+ * @brief 接合面の検出: 定義ファイルの全解の統合メッシュについて、旧実装と新実装の時間を比べます。
+ */
+void benchCoincidentFaces(const std::string& definition_file, int repeat) {
+    CoreGraph core_graph;
+    std::vector<ConnectionRule> rules;
+    std::map<std::string, ObjMesh> mesh_data;
+    loadDefinitions(definition_file, core_graph, rules, mesh_data);
+    if (mesh_data.empty()) {
+        std::cout << definition_file << ": no VERTEX_MESH sections, skipped." << std::endl;
+        return;
+    }
+
+    std::ostringstream discarded_log;
+    int n = std::max(1, core_graph.vertexSize() - 1);
+    GraphData base_data = make_base_graph(core_graph, rules, n, discarded_log, BaseGraphOptions{false});
+    PreparedTemplates templates = prepareTemplates(base_data, mesh_data);
+
+    std::vector<MergedMesh> merged;
+    findAllConstrainedGraphs(base_data, core_graph, "0_a", discarded_log,
+        [&](const std::set<std::string>& solution) {
+            MergedMesh m;
+            for (const std::string& vertex_name : solution) {
+                int vertex_id = findBaseVertex(base_data, vertex_name);
+                appendInstance(templates, base_data, instanceForVertex(templates, base_data, vertex_id),
+                               m.mesh, m.grid_vertices);
+            }
+            merged.push_back(std::move(m));
+        });
+    if (merged.empty()) {
+        std::cout << definition_file << ": no solutions, skipped." << std::endl;
+        return;
+    }
+
+    // 結果が一致することを確認
+    long long total_faces = 0;
+    for (const MergedMesh& m : merged) {
+        std::vector<bool> expected, actual;
+        int expected_count = legacyMarkCoincidentFaces(m.mesh, m.grid_vertices, expected);
+        int actual_count = markCoincidentFaces(m.mesh, m.grid_vertices, actual);
+        if (expected != actual || expected_count != actual_count) {
+            std::cout << definition_file << ": MISMATCH between legacy and hashed coincident-face detection!" << std::endl;
+            return;
+        }
+        total_faces += m.mesh.faceSize();
+    }
+
+    long long checksum = 0; // 最適化で計算が消えないように結果を足し込む
+    std::vector<bool> to_delete;
+    auto start = BenchClock::now();
+    for (int r = 0; r < repeat; ++r) {
+        for (const MergedMesh& m : merged) checksum += legacyMarkCoincidentFaces(m.mesh, m.grid_vertices, to_delete);
+    }
+    double legacy_ms = elapsedMs(start);
+    start = BenchClock::now();
+    for (int r = 0; r < repeat; ++r) {
+        for (const MergedMesh& m : merged) checksum -= markCoincidentFaces(m.mesh, m.grid_vertices, to_delete);
+    }
+    double hashed_ms = elapsedMs(start);
+
+    double faces = static_cast<double>(total_faces) * repeat;
+    std::cout << definition_file << ": coincident faces, " << merged.size() << " solutions x " << repeat << " repeats ("
+              << total_faces << " faces per pass)" << std::endl;
+    std::cout << "  legacy (std::map/std::set): " << legacy_ms << " ms (" << legacy_ms * 1e6 / faces << " ns/face)" << std::endl;
+    std::cout << "  hashed (open addressing):   " << hashed_ms << " ms (" << hashed_ms * 1e6 / faces << " ns/face)" << std::endl;
+    std::cout << "  speedup: " << (hashed_ms > 0 ? legacy_ms / hashed_ms : 0.0) << "x"
+              << (checksum != 0 ? " (checksum mismatch!)" : "") << std::endl;
+}
+
+// 増分処理の検証・計測用オブザーバ: 探索木に沿って保守した双対グラフを、解ごとに書き出す
+// (labels があれば解ごとの正規ラベルを記録し、無ければ辺の数を checksum に足し込むだけ)
+class IncrementalDualRecorder : public SearchPathObserver {
+public:
+    IncrementalDualRecorder(const GraphData& base_data, const PreparedTemplates& templates, const IndexedSearchGraph& g,
+                            std::map<std::set<std::string>, std::string>* labels, long long& checksum)
+        : g_(g), geometry_(base_data, templates), labels_(labels), checksum_(checksum) {
+        for (const std::string& name : g.names) base_vertex_.push_back(findBaseVertex(base_data, name));
+    }
+
+    void pushVertex(int vertex) override { geometry_.pushPart(base_vertex_[vertex]); }
+    void popVertex() override { geometry_.popPart(); }
+    void solutionFound(const std::vector<int>& solution) override {
+        IntGraph dual_graph = geometry_.dualGraph();
+        checksum_ += dual_graph.edgeSize();
+        if (labels_) (*labels_)[indexedSolutionToNames(g_, solution)] = getCanonicalLabel(dual_graph);
+    }
+
+private:
+    const IndexedSearchGraph& g_;
+    IncrementalSolutionGeometry geometry_;
+    std::map<std::set<std::string>, std::string>* labels_;
+    long long& checksum_;
+    std::vector<int> base_vertex_;
+};
+
+/**
+ * @brief 双対グラフの増分処理: 全解について、解ごとのメッシュ構築 + 双対グラフ構築 (通常の方法) と、
+ * 探索木に沿った増分処理 (--incremental) の双対グラフの正規ラベルが一致することを確かめ、時間を比べます。
+ * 増分処理の時間は探索を含むので、探索だけの時間も併せて示します。
+ */
+void benchIncrementalGeometry(const std::string& definition_file, int repeat) {
+    CoreGraph core_graph;
+    std::vector<ConnectionRule> rules;
+    std::map<std::string, ObjMesh> mesh_data;
+    loadDefinitions(definition_file, core_graph, rules, mesh_data);
+    if (mesh_data.empty()) {
+        std::cout << definition_file << ": no VERTEX_MESH sections, skipped." << std::endl;
+        return;
+    }
+
+    std::ostringstream discarded_log;
+    GraphData base_data = make_base_graph(core_graph, rules, defaultLatticeDepth(core_graph), discarded_log,
+                                          BaseGraphOptions{false});
+    PreparedTemplates templates = prepareTemplates(base_data, mesh_data);
+    std::vector<std::set<std::string>> solutions =
+        findAllConstrainedGraphs(base_data, core_graph, "0_a", discarded_log);
+    if (solutions.empty()) {
+        std::cout << definition_file << ": no solutions, skipped." << std::endl;
+        return;
+    }
+
+    // 結果が一致することを確認 (解ごとの正規ラベル)
+    long long checksum = 0; // 最適化で計算が消えないように結果を足し込む
+    std::map<std::set<std::string>, std::string> incremental_labels;
+    SearchOptions options;
+    options.path_observer_factory = [&](const IndexedSearchGraph& g) {
+        return std::unique_ptr<SearchPathObserver>(
+            new IncrementalDualRecorder(base_data, templates, g, &incremental_labels, checksum));
+    };
+    findAllConstrainedGraphs(base_data, core_graph, "0_a", discarded_log, SolutionSink(), options);
+    if (incremental_labels.size() != solutions.size()) {
+        std::cout << definition_file << ": MISMATCH between per-solution and incremental dual graphs (solution count)!" << std::endl;
+        return;
+    }
+    for (const std::set<std::string>& solution : solutions) {
+        PackedMesh mesh = buildSolutionMesh(solution, base_data, templates, discarded_log);
+        auto found = incremental_labels.find(solution);
+        if (found == incremental_labels.end() || found->second != getCanonicalLabel(buildDualGraph(mesh))) {
+            std::cout << definition_file << ": MISMATCH between per-solution and incremental dual graphs!" << std::endl;
+            return;
+        }
+    }
+
+    auto start = BenchClock::now();
+    for (int r = 0; r < repeat; ++r) {
+        findAllConstrainedGraphs(base_data, core_graph, "0_a", discarded_log, SolutionSink());
+    }
+    double search_ms = elapsedMs(start);
+    start = BenchClock::now();
+    for (int r = 0; r < repeat; ++r) {
+        for (const std::set<std::string>& solution : solutions) {
+            checksum += buildDualGraph(buildSolutionMesh(solution, base_data, templates, discarded_log)).edgeSize();
+        }
+    }
+    double per_solution_ms = elapsedMs(start);
+    options.path_observer_factory = [&](const IndexedSearchGraph& g) {
+        return std::unique_ptr<SearchPathObserver>(new IncrementalDualRecorder(base_data, templates, g, nullptr, checksum));
+    };
+    start = BenchClock::now();
+    for (int r = 0; r < repeat; ++r) {
+        findAllConstrainedGraphs(base_data, core_graph, "0_a", discarded_log, SolutionSink(), options);
+    }
+    double incremental_ms = elapsedMs(start);
+
+    std::cout << definition_file << ": dual graphs, " << solutions.size() << " solutions x " << repeat << " repeats"
+              << " (canonical labels match)" << std::endl;
+    std::cout << "  search only:                    " << search_ms / repeat << " ms/pass" << std::endl;
+    std::cout << "  per-solution mesh + dual graph: " << per_solution_ms / repeat << " ms/pass (after the search)" << std::endl;
+    std::cout << "  incremental along the search:   " << incremental_ms / repeat << " ms/pass (including the search)" << std::endl;
+    std::cout << "  speedup: " << (incremental_ms > 0 ? (search_ms + per_solution_ms) / incremental_ms : 0.0) << "x"
+              << (checksum < 0 ? " (checksum overflow!)" : "") << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int repeat = 2000;
+    std::vector<std::string> definition_files;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--repeat" && i + 1 < argc) {
+            repeat = std::max(1, std::stoi(argv[++i]));
+        } else {
+            definition_files.push_back(arg);
+        }
+    }
+    if (definition_files.empty()) {
+        for (int k = 4; k <= 11; ++k) definition_files.push_back("graph_definitions/" + std::to_string(k) + ".txt");
+    }
+
+    for (const std::string& definition_file : definition_files) {
+        try {
+            std::ifstream file(definition_file, std::ios::binary);
+            if (!file.is_open()) throw std::runtime_error("Error: Cannot open definition file: " + definition_file);
+            std::ostringstream contents;
+            contents << file.rdbuf();
+            benchParseDefinitions(definition_file, contents.str(), std::max(1, repeat / 10));
+            benchDefinitionCache(definition_file, std::max(1, repeat / 10));
+            benchLogging(definition_file, std::max(1, repeat / 100));
+            benchCoincidentFaces(definition_file, repeat);
+            benchIncrementalGeometry(definition_file, std::max(1, repeat / 100));
+        } catch (const std::exception& e) {
+            std::cout << definition_file << ": " << e.what() << std::endl;
+        }
+    }
+    std::string synthetic = syntheticDefinitions(40);
+    benchParseDefinitions("synthetic (40^3 mesh vertices)", synthetic, std::max(1, repeat / 200));
+    std::string synthetic_file = (std::filesystem::temp_directory_path() / "bench_synthetic.txt").string();
+    std::ofstream(synthetic_file, std::ios::binary) << synthetic;
+    benchDefinitionCache(synthetic_file, std::max(1, repeat / 200));
+    std::remove(synthetic_file.c_str());
+
+    LoadedDefinitions synthetic_definitions;
+    parseDefinitions(synthetic.data(), synthetic.size(), "synthetic", synthetic_definitions.core_graph,
+                     synthetic_definitions.rules, synthetic_definitions.mesh_data);
+    PackedMesh synthetic_mesh = packMesh(synthetic_definitions.mesh_data.at("a"));
+    benchMeshExport("synthetic (40^3 mesh vertices)", synthetic_mesh, std::max(1, repeat / 200));
+
+    // (非同期書き出しは、解のメッシュに近い大きさのファイルを数百個書く条件で測る)
+    std::string small_synthetic = syntheticDefinitions(12);
+    LoadedDefinitions small_definitions;
+    parseDefinitions(small_synthetic.data(), small_synthetic.size(), "synthetic", small_definitions.core_graph,
+                     small_definitions.rules, small_definitions.mesh_data);
+    benchAsyncExport("synthetic (12^3 mesh vertices)", packMesh(small_definitions.mesh_data.at("a")), 500);
+    return 0;
+}
@@ -130,32 +130,18 @@ int main(int argc, char* argv[]) {
     std::cerr << "--- Debugging GraphIsomorphism (Nauty) ---" << std::endl;
 
     // G1: 4頂点・4辺 の「四角形」
-    tdzdd::Graph g1;
-    g1.addEdge("0", "1");
-    g1.addEdge("1", "2");
-    g1.addEdge("2", "3");
-    g1.addEdge("3", "0");
-    g1.update();
-
-    // G2: G1と「同型」なグラフ (ラベル名だけが違う)
-    tdzdd::Graph g2;
-    g2.addEdge("a", "b"); // <-- nautyラッパーが 0 にマッピング
-    g2.addEdge("b", "c"); // <-- 1 にマッピング
-    g2.addEdge("c", "d"); // <-- 2 にマッピング
-    g2.addEdge("d", "a"); // <-- 3 にマッピング
-    g2.update();
+    IntGraph g1 = buildIntGraph(4, {{0, 1}, {1, 2}, {2, 3}, {3, 0}});
+
+    // G2: G1と「同型」なグラフ (頂点IDの振り方だけが違う)
+    IntGraph g2 = buildIntGraph(4, {{2, 0}, {0, 3}, {3, 1}, {1, 2}});
 
     // G3: G1と「同型でない」グラフ (辺の数が違う)
-    tdzdd::Graph g3;
-    g3.addEdge("0", "1");
-    g3.addEdge("1", "2");
-    g3.addEdge("2", "3");
-    g3.update(); // 辺は3つ
+    IntGraph g3 = buildIntGraph(4, {{0, 1}, {1, 2}, {2, 3}}); // 辺は3つ
 
-    std::vector<tdzdd::Graph> test_graphs = {g1, g2, g3};
+    std::vector<IntGraph> test_graphs = {g1, g2, g3};
 
     // フィルターを実行
-    std::map<std::string, tdzdd::Graph> unique_set = filterUniqueGraphsNauty(test_graphs);
+    std::map<std::string, IntGraph> unique_set = filterUniqueGraphsNauty(test_graphs);
 
     std::cerr << "  Input graphs: 3 (g1, g2, g3)" << std::endl;
     std::cerr << "  Unique graphs found (via Nauty): " << unique_set.size() << std::endl;